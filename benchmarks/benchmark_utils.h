@@ -0,0 +1,121 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_BENCHMARK_UTILS_H
+#define PROSTRUCT_BENCHMARK_UTILS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace prostruct::benchmarks
+{
+	struct Timing
+	{
+		double min_ms;
+		double mean_ms;
+	};
+
+	/**
+	 * Runs f repeats times and returns the fastest and the mean wall time.
+	 */
+	template <typename F>
+	Timing time_it(F&& f, int repeats = 5)
+	{
+		Timing timing { std::numeric_limits<double>::infinity(), 0.0 };
+		for (int i = 0; i < repeats; ++i)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			f();
+			auto end = std::chrono::high_resolution_clock::now();
+			double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+			timing.min_ms = std::min(timing.min_ms, elapsed);
+			timing.mean_ms += elapsed / repeats;
+		}
+		return timing;
+	}
+
+	inline void report(const std::string& name, size_t n_atoms, const Timing& timing)
+	{
+		std::printf("%-40s %10zu atoms %12.3f ms (min) %12.3f ms (mean) %10.1f ns/atom\n",
+			name.c_str(), n_atoms, timing.min_ms, timing.mean_ms,
+			n_atoms > 0 ? timing.min_ms * 1e6 / n_atoms : 0.0);
+	}
+
+	/**
+	 * Writes a PDB file with (at least) n_atoms atoms by tiling the ATOM records
+	 * of template_file. Each copy is translated and gets its own chain ids and
+	 * residue numbers, so the result is a valid multi chain structure.
+	 * The file is cut at a residue boundary and the number of atoms written is returned.
+	 */
+	inline size_t write_synthetic_pdb(
+		const std::string& template_file, const std::string& output_file, size_t n_atoms)
+	{
+		static const std::string chain_ids
+			= "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+		std::ifstream input(template_file);
+		if (!input.is_open())
+			throw "File does not exist!";
+
+		std::vector<std::string> atom_lines;
+		std::string line;
+		while (std::getline(input, line))
+		{
+			if (line.compare(0, 4, "ATOM") == 0)
+				atom_lines.push_back(line);
+		}
+
+		std::ofstream output(output_file);
+		const size_t n_chain_slots = chain_ids.size() / 2;
+
+		size_t written = 0;
+		for (size_t copy = 0; written < n_atoms; ++copy)
+		{
+			// the template has two chains (L and H), each copy gets a fresh pair of ids
+			// and once all ids are used the residue numbers are shifted instead
+			const size_t slot = copy % n_chain_slots;
+			const int residue_offset = static_cast<int>(copy / n_chain_slots) * 200;
+			// copies are laid out on a 20 x 20 x n grid so the coordinates fit in 8 columns
+			const double shift_x = 60.0 * static_cast<double>(copy % 20);
+			const double shift_y = 60.0 * static_cast<double>((copy / 20) % 20);
+			const double shift_z = 60.0 * static_cast<double>(copy / 400);
+			std::string previous_residue;
+
+			for (const auto& atom_line : atom_lines)
+			{
+				const std::string residue_id = atom_line.substr(17, 10);
+				if (written >= n_atoms && residue_id != previous_residue)
+					break;
+				previous_residue = residue_id;
+
+				const char chain = atom_line[21] == 'L' ? chain_ids[2 * slot] : chain_ids[2 * slot + 1];
+				const int residue_number = std::stoi(atom_line.substr(22, 4)) + residue_offset;
+				const double x = std::stod(atom_line.substr(30, 8)) + shift_x;
+				const double y = std::stod(atom_line.substr(38, 8)) + shift_y;
+				const double z = std::stod(atom_line.substr(46, 8)) + shift_z;
+
+				char buffer[128];
+				std::snprintf(buffer, sizeof(buffer), "%.21s%c%4d%.4s%8.3f%8.3f%8.3f%s",
+					atom_line.c_str(), chain, residue_number, atom_line.c_str() + 26, x, y, z,
+					atom_line.c_str() + 54);
+				output << buffer << '\n';
+				++written;
+			}
+			output << "TER\n";
+		}
+		output << "END\n";
+		return written;
+	}
+}
+
+#endif // PROSTRUCT_BENCHMARK_UTILS_H
@@ -0,0 +1,53 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/pdb/PDB.h>
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+template <typename T>
+void run(const std::string& filename)
+{
+	const std::string cache_file = filename + ".cache";
+	PDB<T> pdb(filename);
+	pdb.save(cache_file);
+	const size_t n_atoms = pdb.n_atoms();
+
+	auto parse_timing = time_it([&]() { PDB<T> parsed(filename); });
+	auto save_timing = time_it([&]() { pdb.save(cache_file); });
+	auto load_timing = time_it([&]() { PDB<T>::load(cache_file); });
+
+	if (!arma::approx_equal(PDB<T>::load(cache_file)->get_xyz(), pdb.get_xyz(), "absdiff", 0))
+		std::printf("WARNING: the cache of %s does not match the structure\n", filename.c_str());
+
+	std::printf("%s (%s)\n", filename.c_str(), demangled_type<T>().c_str());
+	report("  PDB (parse the text file)", n_atoms, parse_timing);
+	report("  PDB::save (structure cache)", n_atoms, save_timing);
+	report("  PDB::load (structure cache)", n_atoms, load_timing);
+	std::remove(cache_file.c_str());
+}
+
+int main(int argc, char** argv)
+{
+	const std::string template_file = argc > 1 ? argv[1] : "test.pdb";
+
+	run<float>(template_file);
+	run<double>(template_file);
+
+	for (size_t n_atoms : { 10000, 100000, 1000000 })
+	{
+		const std::string synthetic_file = "synthetic_" + std::to_string(n_atoms) + ".pdb";
+		write_synthetic_pdb(template_file, synthetic_file, n_atoms);
+		run<float>(synthetic_file);
+		run<double>(synthetic_file);
+		std::remove(synthetic_file.c_str());
+	}
+}
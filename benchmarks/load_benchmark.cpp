@@ -0,0 +1,74 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/parsers/PDBparser.h>
+#include <prostruct/pdb/PDB.h>
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+// the residue by residue insert_cols/insert_rows growth that PDB used before the
+// two pass build, kept here as the baseline
+template <typename T>
+arma::uword append_with_insert_cols(const parsers::ParsedStructure<T>& structure)
+{
+	arma::Mat<T> xyz(3, 0);
+	arma::Col<T> radii(0);
+
+	for (const auto& residue : structure.residues)
+	{
+		arma::Mat<T> residue_xyz(3, residue.n_atoms);
+		for (size_t i = 0; i < residue.n_atoms; ++i)
+		{
+			const auto& record = structure.atoms[residue.first_atom + i];
+			residue_xyz.at(0, i) = record.x;
+			residue_xyz.at(1, i) = record.y;
+			residue_xyz.at(2, i) = record.z;
+		}
+		xyz.insert_cols(xyz.n_cols, residue_xyz);
+		radii.insert_rows(radii.n_rows, arma::Col<T>(residue.n_atoms, arma::fill::ones));
+	}
+	return xyz.n_cols;
+}
+
+template <typename T>
+void run(const std::string& filename, bool run_baseline)
+{
+	const auto structure = parsers::parse_pdb<T>(filename);
+	const size_t n_atoms = structure.atoms.size();
+
+	std::printf("%s (%s)\n", filename.c_str(), demangled_type<T>().c_str());
+
+	if (run_baseline)
+	{
+		auto baseline_timing = time_it([&]() { append_with_insert_cols(structure); }, 3);
+		report("  grow with insert_cols (no parsing)", n_atoms, baseline_timing);
+	}
+
+	auto load_timing = time_it([&]() { PDB<T> pdb(filename); }, 3);
+	report("  PDB construction (parse + build)", n_atoms, load_timing);
+}
+
+int main(int argc, char** argv)
+{
+	const std::string template_file = argc > 1 ? argv[1] : "test.pdb";
+
+	// the time per atom of the PDB construction should stay constant as the structures grow,
+	// whereas the insert_cols baseline grows linearly (it is quadratic in total), so it is
+	// only run up to 100k atoms
+	for (size_t n_atoms : { 1000, 10000, 100000, 1000000 })
+	{
+		const std::string synthetic_file = "synthetic_" + std::to_string(n_atoms) + ".pdb";
+		write_synthetic_pdb(template_file, synthetic_file, n_atoms);
+		run<float>(synthetic_file, n_atoms <= 100000);
+		run<double>(synthetic_file, n_atoms <= 100000);
+		std::remove(synthetic_file.c_str());
+	}
+}
@@ -0,0 +1,138 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/core/engine.h>
+#include <prostruct/pdb/PDB.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+namespace
+{
+	int thread_id()
+	{
+#ifdef _OPENMP
+		return omp_get_thread_num();
+#else
+		return 0;
+#endif
+	}
+
+	int max_threads()
+	{
+#ifdef _OPENMP
+		return omp_get_max_threads();
+#else
+		return 1;
+#endif
+	}
+
+	using Clock = std::chrono::steady_clock;
+
+	/** The work done by one thread, padded so that threads do not share cache lines */
+	struct alignas(64) ThreadLoad
+	{
+		size_t n_pairs = 0;
+		Clock::time_point last_pair;
+	};
+
+	/**
+	 * A CA-CA distance kernel that counts the pairs computed by each thread and
+	 * when each thread computed its last pair
+	 */
+	auto counting_kernel(std::vector<ThreadLoad>& loads)
+	{
+		return [&loads](const std::shared_ptr<Residue<float>>& residue,
+				   const std::shared_ptr<Residue<float>>& residue_neighbour) -> float {
+			auto& load = loads[thread_id()];
+			// reading the clock at every pair would dominate the kernel
+			if (++load.n_pairs % 256 == 0)
+				load.last_pair = Clock::now();
+			const float* a = residue->xyz_ref().colptr(1);
+			const float* b = residue_neighbour->xyz_ref().colptr(1);
+			const float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+			return std::sqrt(dx * dx + dy * dy + dz * dz);
+		};
+	}
+
+	// the schedule that pairwise_residue_kernel_engine used before the tiles, kept
+	// here as the baseline: static scheduling of the rows of the upper triangle,
+	// then a single threaded symmatu
+	template <typename Kernel>
+	arma::Cube<float> untiled_engine(const residueVector<float>& residues, Kernel kernel)
+	{
+		arma::Cube<float> result(residues.size(), residues.size(), 1, arma::fill::zeros);
+#pragma omp parallel for
+		for (size_t i = 0; i < residues.size(); ++i)
+		{
+			for (size_t j = i + 1; j < residues.size(); ++j)
+				result.at(i, j, 0) = kernel(residues[i], residues[j]);
+		}
+		result.slice(0) = arma::symmatu(result.slice(0));
+		return result;
+	}
+
+	template <typename F>
+	void run(const std::string& name, size_t n_residues, F&& engine)
+	{
+		std::vector<ThreadLoad> loads(max_threads());
+		const auto start = Clock::now();
+		engine(loads);
+		const auto end = Clock::now();
+
+		const double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+		std::printf("%-40s %10zu residues %12.3f ms\n", name.c_str(), n_residues, total_ms);
+
+		size_t total_pairs = 0;
+		for (const auto& load : loads)
+			total_pairs += load.n_pairs;
+		for (size_t thread = 0; thread < loads.size(); ++thread)
+		{
+			const double finished_ms = loads[thread].n_pairs == 0
+				? 0.0
+				: std::chrono::duration<double, std::milli>(loads[thread].last_pair - start)
+					  .count();
+			std::printf("    thread %3zu %14zu pairs (%5.1f%%) %12.3f ms until its last pair\n",
+				thread, loads[thread].n_pairs,
+				total_pairs > 0 ? 100.0 * loads[thread].n_pairs / total_pairs : 0.0, finished_ms);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string template_file = argc > 1 ? argv[1] : "test.pdb";
+
+	// the 20k residue matrices take 1.6 GB each, so only float is run
+	for (size_t n_residues : { 5000, 20000 })
+	{
+		// the template has about 8 atoms per residue, so this writes enough residues
+		const std::string synthetic_file = "synthetic_" + std::to_string(n_residues) + ".pdb";
+		write_synthetic_pdb(template_file, synthetic_file, 10 * n_residues);
+		PDB<float> pdb(synthetic_file);
+		std::remove(synthetic_file.c_str());
+
+		auto residues = pdb.get_residues();
+		residues.resize(std::min(residues.size(), n_residues));
+
+		run("  untiled (static rows + symmatu)", residues.size(),
+			[&](std::vector<ThreadLoad>& loads) {
+				untiled_engine(residues, counting_kernel(loads));
+			});
+		run("  pairwise_residue_kernel_engine (tiled)", residues.size(),
+			[&](std::vector<ThreadLoad>& loads) {
+				core::pairwise_residue_kernel_engine(residues, 0, counting_kernel(loads));
+			});
+	}
+}
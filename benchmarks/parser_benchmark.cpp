@@ -0,0 +1,110 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/parsers/PDBparser.h>
+#include <prostruct/parsers/mapped_file.h>
+
+#include <cmath>
+#include <fstream>
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+// the getline/substr/stod decoding that the parser used before the mmap decoder,
+// kept here as the baseline
+double decode_with_getline(const std::string& filename, size_t& n_atoms)
+{
+	auto remove_whitespace = [](std::string& str) {
+		str.erase(std::remove_if(str.begin(), str.end(), isspace), str.end());
+	};
+
+	std::ifstream file(filename);
+	std::string line;
+	double checksum = 0.0;
+	n_atoms = 0;
+
+	while (std::getline(file, line))
+	{
+		auto record = line.substr(0, 5);
+		remove_whitespace(record);
+		if (record == "ATOM")
+		{
+			auto name = line.substr(12, 4);
+			auto residue = line.substr(17, 3);
+			auto chainID = line.substr(21, 1);
+			auto resSeqStr = line.substr(22, 4);
+			auto insCode = line.substr(26, 1);
+			double x = std::stod(line.substr(30, 8));
+			double y = std::stod(line.substr(38, 8));
+			double z = std::stod(line.substr(46, 8));
+			std::string element = line.substr(76, 2);
+			remove_whitespace(name);
+			remove_whitespace(element);
+			remove_whitespace(resSeqStr);
+			remove_whitespace(insCode);
+			checksum += x + y + z + name.size() + residue.size() + chainID.size() + element.size()
+				+ resSeqStr.size() + insCode.size();
+			++n_atoms;
+		}
+	}
+	return checksum;
+}
+
+double decode_with_mmap(const std::string& filename, size_t& n_atoms)
+{
+	parsers::MappedFile file(filename);
+	double checksum = 0.0;
+	n_atoms = 0;
+
+	parsers::for_each_atom_record<double>(
+		file.view(), [&](const parsers::AtomRecord<double>& record) {
+			checksum += record.x + record.y + record.z + record.name.size()
+				+ record.residue_name.size() + record.chain_id.size() + record.element.size()
+				+ record.residue_sequence.size() + record.insertion_code.size();
+			++n_atoms;
+		});
+	return checksum;
+}
+
+void run(const std::string& filename)
+{
+	size_t n_atoms_getline = 0, n_atoms_mmap = 0;
+	double checksum_getline = 0.0, checksum_mmap = 0.0;
+
+	auto getline_timing
+		= time_it([&]() { checksum_getline = decode_with_getline(filename, n_atoms_getline); });
+	auto mmap_timing
+		= time_it([&]() { checksum_mmap = decode_with_mmap(filename, n_atoms_mmap); });
+
+	if (n_atoms_getline != n_atoms_mmap || std::abs(checksum_getline - checksum_mmap) > 1e-6 * std::abs(checksum_getline))
+		std::printf("WARNING: decoders disagree on %s\n", filename.c_str());
+
+	std::printf("%s\n", filename.c_str());
+	report("  decode (getline + substr + stod)", n_atoms_getline, getline_timing);
+	report("  decode (mmap + string_view + from_chars)", n_atoms_mmap, mmap_timing);
+
+	auto parse_timing = time_it([&]() { parsers::parse_pdb<double>(filename); });
+	report("  parse_pdb (decode + group residues)", n_atoms_mmap, parse_timing);
+}
+
+int main(int argc, char** argv)
+{
+	const std::string template_file = argc > 1 ? argv[1] : "test.pdb";
+
+	run(template_file);
+
+	for (size_t n_atoms : { 10000, 100000, 1000000 })
+	{
+		const std::string synthetic_file = "synthetic_" + std::to_string(n_atoms) + ".pdb";
+		write_synthetic_pdb(template_file, synthetic_file, n_atoms);
+		run(synthetic_file);
+		std::remove(synthetic_file.c_str());
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/pdb/sasa_kernel.h>
+#include <prostruct/utils/io.h>
+
+#include <cmath>
+#include <random>
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+namespace
+{
+	/**
+	 * n_atoms atoms with n_neighbours neighbour spheres each, at random
+	 * directions and at distances where they cover part of the atom sphere
+	 */
+	template <typename T>
+	std::vector<geometry::NeighbourSpheres<T>> random_neighbours(
+		size_t n_atoms, size_t n_neighbours, std::mt19937& generator)
+	{
+		std::normal_distribution<T> direction(0, 1);
+		std::uniform_real_distribution<T> distance(2.5, 5.5);
+		std::uniform_real_distribution<T> radius(1.5, 2.0 + 1.4);
+
+		std::vector<geometry::NeighbourSpheres<T>> result(n_atoms);
+		for (auto& neighbours : result)
+		{
+			for (size_t i = 0; i < n_neighbours; ++i)
+			{
+				T x = direction(generator), y = direction(generator), z = direction(generator);
+				const T scale = distance(generator) / std::sqrt(x * x + y * y + z * z);
+				neighbours.push_back(x * scale, y * scale, z * scale, radius(generator));
+			}
+		}
+		return result;
+	}
+
+	const char* level_name(geometry::SimdLevel level)
+	{
+		switch (level)
+		{
+		case geometry::SimdLevel::AVX2:
+			return "AVX2";
+		case geometry::SimdLevel::AVX512:
+			return "AVX-512";
+		default:
+			return "scalar";
+		}
+	}
+
+	template <typename T>
+	void run(size_t n_atoms, size_t n_neighbours, arma::uword n_points)
+	{
+		std::mt19937 generator(42);
+		const auto neighbours = random_neighbours<T>(n_atoms, n_neighbours, generator);
+		const auto& sphere = geometry::cached_sphere_points<T>(n_points);
+		const T radius = static_cast<T>(1.87 + 1.4);
+
+		std::printf("%zu atoms, %zu neighbours, %u points (%s), detected %s\n", n_atoms,
+			n_neighbours, static_cast<unsigned>(n_points), demangled_type<T>().c_str(),
+			level_name(geometry::detected_simd_level()));
+
+		arma::uword scalar_count = 0;
+		double scalar_ms = 0;
+		for (auto level :
+			{ geometry::SimdLevel::Scalar, geometry::SimdLevel::AVX2, geometry::SimdLevel::AVX512 })
+		{
+			// levels above the detected one fall back to it, so they are not timed
+			if (level > geometry::detected_simd_level())
+				continue;
+
+			arma::uword count = 0;
+			auto timing = time_it([&]() {
+				count = 0;
+				for (const auto& atom_neighbours : neighbours)
+					count += geometry::count_accessible_points(
+						sphere, radius, atom_neighbours, level);
+			});
+
+			if (level == geometry::SimdLevel::Scalar)
+			{
+				scalar_count = count;
+				scalar_ms = timing.min_ms;
+			}
+			else if (count != scalar_count)
+				std::printf("WARNING: the %s kernel counts %u points, the scalar one %u\n",
+					level_name(level), static_cast<unsigned>(count),
+					static_cast<unsigned>(scalar_count));
+
+			report(std::string("  count_accessible_points (") + level_name(level) + ")", n_atoms,
+				timing);
+			std::printf("    %.2fx the scalar kernel\n", scalar_ms / timing.min_ms);
+		}
+	}
+}
+
+int main()
+{
+	run<float>(2000, 25, 960);
+	run<double>(2000, 25, 960);
+}
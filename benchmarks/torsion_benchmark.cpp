@@ -0,0 +1,78 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "benchmark_utils.h"
+
+#include <prostruct/pdb/PDB.h>
+#include <prostruct/utils/io.h>
+
+using namespace prostruct;
+using namespace prostruct::benchmarks;
+
+namespace
+{
+	constexpr int n_frames = 10000;
+
+	void report_frames(const std::string& name, const Timing& timing)
+	{
+		std::printf("%-48s %12.3f ms (min) %12.3f ms (mean) per %d frames\n", name.c_str(),
+			timing.min_ms, timing.mean_ms, n_frames);
+	}
+
+	/**
+	 * The backbone torsions of every frame of a trajectory, as n_frames calls on
+	 * the same structure: the per frame cost of each way to get them.
+	 */
+	template <typename T>
+	void run(const std::string& filename)
+	{
+		PDB<T> pdb(filename);
+		std::printf("%d residues (%s)\n", pdb.n_residues(), demangled_type<T>().c_str());
+
+		T checksum = 0;
+		report_frames("  calculate_phi, calculate_psi, calculate_omega", time_it([&]() {
+			for (int frame = 0; frame < n_frames; ++frame)
+			{
+				checksum += pdb.calculate_phi()(1) + pdb.calculate_psi()(1)
+					+ pdb.calculate_omega()(1);
+			}
+		}, 3));
+
+		report_frames("  calculate_backbone_torsions()", time_it([&]() {
+			for (int frame = 0; frame < n_frames; ++frame)
+				checksum += pdb.calculate_backbone_torsions()(0, 1);
+		}, 3));
+
+		arma::Mat<T> torsions;
+		report_frames("  calculate_backbone_torsions(result)", time_it([&]() {
+			for (int frame = 0; frame < n_frames; ++frame)
+			{
+				pdb.calculate_backbone_torsions(torsions);
+				checksum += torsions(0, 1);
+			}
+		}, 3));
+
+		// keeps the calls from being optimised away
+		std::printf("  (checksum %g)\n", static_cast<double>(checksum));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string template_file = argc > 1 ? argv[1] : "test.pdb";
+
+	run<float>(template_file);
+	run<double>(template_file);
+
+	// a larger structure, about 2000 residues
+	const std::string synthetic_file = "synthetic_torsions.pdb";
+	write_synthetic_pdb(template_file, synthetic_file, 16000);
+	run<float>(synthetic_file);
+	run<double>(synthetic_file);
+	std::remove(synthetic_file.c_str());
+}
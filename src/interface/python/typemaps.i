@@ -10,6 +10,102 @@
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
 
 #include "numpy/ndarrayobject.h"
+
+namespace prostruct::python
+{
+	template <typename M>
+	void delete_capsule(PyObject* capsule)
+	{
+		delete static_cast<M*>(PyCapsule_GetPointer(capsule, "prostruct.arma"));
+	}
+
+	/**
+	 * Moves value to the heap and returns a NumPy array over its memory, which
+	 * owns value through a capsule, so the result is returned without a copy.
+	 */
+	template <typename M>
+	PyObject* move_to_numpy(M& value, int nd, npy_intp* dims, int type)
+	{
+		auto* owner = new M(std::move(value));
+		PyObject* array = PyArray_SimpleNewFromData(nd, dims, type, owner->memptr());
+		if (array == NULL)
+		{
+			delete owner;
+			return NULL;
+		}
+		PyObject* capsule = PyCapsule_New(owner, "prostruct.arma", delete_capsule<M>);
+		if (capsule == NULL)
+		{
+			delete owner;
+			Py_DECREF(array);
+			return NULL;
+		}
+		// steals the reference to capsule, which frees owner if this fails
+		if (PyArray_SetBaseObject((PyArrayObject*) array, capsule) < 0)
+		{
+			Py_DECREF(array);
+			return NULL;
+		}
+		return array;
+	}
+
+	/**
+	 * A read-only NumPy array over the memory of value, which belongs to the
+	 * Python object owner. The array keeps owner alive, and without an owner
+	 * value is copied.
+	 */
+	template <typename M>
+	PyObject* view_to_numpy(const M& value, int nd, npy_intp* dims, int type, PyObject* owner)
+	{
+		if (owner == NULL)
+		{
+			M copy(value);
+			return move_to_numpy(copy, nd, dims, type);
+		}
+		PyObject* array = PyArray_New(&PyArray_Type, nd, dims, type, NULL,
+			const_cast<typename M::elem_type*>(value.memptr()), 0,
+			NPY_ARRAY_C_CONTIGUOUS | NPY_ARRAY_ALIGNED, NULL);
+		if (array == NULL)
+			return NULL;
+		Py_INCREF(owner);
+		if (PyArray_SetBaseObject((PyArrayObject*) array, owner) < 0)
+		{
+			Py_DECREF(array);
+			return NULL;
+		}
+		return array;
+	}
+
+	/** Copies input (a NumPy array or anything NumPy can convert) into result */
+	template <typename T>
+	bool numpy_to_arma(PyObject* input, int type, arma::Col<T>& result)
+	{
+		auto* array = (PyArrayObject*) PyArray_FROMANY(
+			input, type, 0, 0, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+		if (array == NULL)
+			return false;
+		result = arma::Col<T>(static_cast<T*>(PyArray_DATA(array)), PyArray_SIZE(array));
+		Py_DECREF(array);
+		return true;
+	}
+
+	/**
+	 * Copies the 2D array input into result, with the layout of the Mat typemaps:
+	 * the (a, b) NumPy array is the b x a matrix
+	 */
+	template <typename T>
+	bool numpy_to_arma(PyObject* input, int type, arma::Mat<T>& result)
+	{
+		auto* array = (PyArrayObject*) PyArray_FROMANY(
+			input, type, 2, 2, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+		if (array == NULL)
+			return false;
+		result = arma::Mat<T>(
+			static_cast<T*>(PyArray_DATA(array)), PyArray_DIM(array, 1), PyArray_DIM(array, 0));
+		Py_DECREF(array);
+		return true;
+	}
+}
 %}
 
 %feature("python:slot", "tp_repr", functype="reprfunc") prostruct::PDB::to_string;
@@ -26,12 +122,14 @@
 	}
 }
 
+// the returned armadillo object is handed over to NumPy without a copy
 %define ARMA_COL_OUT(TYPE, NUMPY_TYPE)
 %typemap(out) arma::Col<TYPE>
 {
-	npy_intp size[1] = {static_cast<npy_intp>($1.size())};
-	$result = PyArray_SimpleNew(1, size, NUMPY_TYPE);
-	memcpy(PyArray_DATA((PyArrayObject *) $result), $1.memptr(), sizeof(TYPE) * $1.size());
+	npy_intp size[1] = {static_cast<npy_intp>($1.n_elem)};
+	$result = prostruct::python::move_to_numpy(
+		static_cast<arma::Col<TYPE>&>($1), 1, size, NUMPY_TYPE);
+	if ($result == NULL) SWIG_fail;
 }
 %enddef
 
@@ -39,8 +137,67 @@
 %typemap(out) arma::Mat<TYPE>
 {
 	npy_intp size[2] = {static_cast<npy_intp>($1.n_cols), static_cast<npy_intp>($1.n_rows)};
-	$result = PyArray_SimpleNew(2, size, NUMPY_TYPE);
-	memcpy(PyArray_DATA((PyArrayObject *) $result), $1.memptr(), sizeof(TYPE) * $1.size());
+	$result = prostruct::python::move_to_numpy(
+		static_cast<arma::Mat<TYPE>&>($1), 2, size, NUMPY_TYPE);
+	if ($result == NULL) SWIG_fail;
+}
+%enddef
+
+// references to the buffers of a structure (e.g. get_xyz_view) become read-only
+// views, which keep the structure alive. With -builtin, self is the Python
+// object of the structure
+%define ARMA_COL_VIEW_OUT(TYPE, NUMPY_TYPE)
+%typemap(out) const arma::Col<TYPE>&
+{
+	npy_intp size[1] = {static_cast<npy_intp>($1->n_elem)};
+	$result = prostruct::python::view_to_numpy(*$1, 1, size, NUMPY_TYPE, self);
+	if ($result == NULL) SWIG_fail;
+}
+%enddef
+
+%define ARMA_MAT_VIEW_OUT(TYPE, NUMPY_TYPE)
+%typemap(out) const arma::Mat<TYPE>&
+{
+	npy_intp size[2] = {static_cast<npy_intp>($1->n_cols), static_cast<npy_intp>($1->n_rows)};
+	$result = prostruct::python::view_to_numpy(*$1, 2, size, NUMPY_TYPE, self);
+	if ($result == NULL) SWIG_fail;
+}
+%enddef
+
+// the arguments and results of the batch kernels of CustomPDB, the arguments
+// are moved to NumPy like the results above
+%define ARMA_DIRECTOR(TYPE, NUMPY_TYPE)
+%typemap(directorin) arma::Col<TYPE>
+{
+	npy_intp size[1] = {static_cast<npy_intp>($1.n_elem)};
+	$input = prostruct::python::move_to_numpy($1, 1, size, NUMPY_TYPE);
+}
+
+%typemap(directorin) arma::Mat<TYPE>
+{
+	npy_intp size[2] = {static_cast<npy_intp>($1.n_cols), static_cast<npy_intp>($1.n_rows)};
+	$input = prostruct::python::move_to_numpy($1, 2, size, NUMPY_TYPE);
+}
+
+%typemap(directorin) arma::Cube<TYPE>
+{
+	npy_intp size[3] = {static_cast<npy_intp>($1.n_slices), static_cast<npy_intp>($1.n_cols),
+		static_cast<npy_intp>($1.n_rows)};
+	$input = prostruct::python::move_to_numpy($1, 3, size, NUMPY_TYPE);
+}
+
+%typemap(directorout) arma::Col<TYPE>
+{
+	if (!prostruct::python::numpy_to_arma($input, NUMPY_TYPE, $result))
+		Swig::DirectorTypeMismatchException::raise(
+			PyExc_TypeError, "Expected a 1D array from the custom kernel");
+}
+
+%typemap(directorout) arma::Mat<TYPE>
+{
+	if (!prostruct::python::numpy_to_arma($input, NUMPY_TYPE, $result))
+		Swig::DirectorTypeMismatchException::raise(
+			PyExc_TypeError, "Expected a 2D array from the custom kernel");
 }
 %enddef
 
@@ -52,4 +209,14 @@ ARMA_MAT_OUT(float, NPY_FLOAT);
 ARMA_MAT_OUT(double, NPY_DOUBLE);
 ARMA_MAT_OUT(arma::uword, NPY_ULONGLONG);
 
+ARMA_COL_VIEW_OUT(float, NPY_FLOAT);
+ARMA_COL_VIEW_OUT(double, NPY_DOUBLE);
+
+ARMA_MAT_VIEW_OUT(float, NPY_FLOAT);
+ARMA_MAT_VIEW_OUT(double, NPY_DOUBLE);
+
+ARMA_DIRECTOR(float, NPY_FLOAT);
+ARMA_DIRECTOR(double, NPY_DOUBLE);
+ARMA_DIRECTOR(arma::uword, NPY_ULONGLONG);
+
 %include "prostruct.i"
\ No newline at end of file
@@ -42,18 +42,28 @@
   #include <prostruct/prostruct.h>
 %}
 
+#ifndef SWIGPYTHON
+// the views have typemaps in Python only, the other interfaces copy with get_xyz and get_radii
+%ignore prostruct::StructBase::get_xyz_view;
+%ignore prostruct::StructBase::get_radii_view;
+#endif
+
 %include "prostruct/struct/utils.h"
 %include "prostruct/struct/chain.h"
 %include "prostruct/struct/residue.h"
 %include "prostruct/pdb/struct_base.h"
 %include "prostruct/struct/chain.h"
 %include "prostruct/pdb/PDB.h"
+%include "prostruct/pdb/ensemble.h"
+%include "prostruct/pdb/trajectory.h"
 
 #ifndef SWIGPERL
 %shared_ptr(prostruct::StructBase<float>)
 %shared_ptr(prostruct::StructBase<double>)
 %shared_ptr(prostruct::PDB<float>)
 %shared_ptr(prostruct::PDB<double>)
+%shared_ptr(prostruct::Ensemble<float>)
+%shared_ptr(prostruct::Ensemble<double>)
 %shared_ptr(prostruct::Chain<float>)
 %shared_ptr(prostruct::Chain<double>)
 %shared_ptr(prostruct::Residue<float>)
@@ -74,6 +84,18 @@
 %template(PDB_float)  prostruct::PDB<float>;
 %template(PDB_double) prostruct::PDB<double>;
 
+#ifndef SWIGPERL
+// the structures of PDB::kabsch_rmsd_matrix
+%template(VectorOfPDB_float)  std::vector<std::shared_ptr<prostruct::PDB<float>>>;
+%template(VectorOfPDB_double) std::vector<std::shared_ptr<prostruct::PDB<double>>>;
+#endif
+
+%template(Ensemble_float)  prostruct::Ensemble<float>;
+%template(Ensemble_double) prostruct::Ensemble<double>;
+
+%template(Trajectory_float)  prostruct::Trajectory<float>;
+%template(Trajectory_double) prostruct::Trajectory<double>;
+
 %template(Chain_float)  prostruct::Chain<float>;
 %template(Chain_double) prostruct::Chain<double>;
 
@@ -81,14 +103,19 @@
 %template(Residue_double) prostruct::Residue<double>;
 
 #ifdef SWIGPYTHON
-%shared_ptr(prostruct::CustomPDB)
-%director prostruct::CustomPDB;
+%shared_ptr(prostruct::CustomPDB<float>)
+%shared_ptr(prostruct::CustomPDB<double>)
+%feature("director") prostruct::CustomPDB<float>;
+%feature("director") prostruct::CustomPDB<double>;
 %feature("director:except") {
     if ($error != NULL) {
         throw Swig::DirectorMethodException();
     }
 }
 %include "prostruct/pdb/custom_pdb.h"
+
+%template(CustomPDB)        prostruct::CustomPDB<float>;
+%template(CustomPDB_double) prostruct::CustomPDB<double>;
 #endif
 
 %init %{
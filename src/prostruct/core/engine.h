@@ -10,15 +10,75 @@
 #define PROSTRUCT_ENGINE_H
 
 #include <armadillo>
+#include <prostruct/pdb/cell_list.h>
 #include <prostruct/struct/utils.h>
 #include <prostruct/utils/tuple_utils.h>
 #include <prostruct/utils/type_traits.h>
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
 namespace prostruct::core
 {
+	namespace detail
+	{
+		/** The number of consecutive residues (the window) a kernel takes */
+		template <typename Kernel>
+		constexpr size_t window_size_v = utils::lambda_properties<std::decay_t<Kernel>>::size;
+
+		/**
+		 * Stores the result of kernel Idx on the window of residues starting at
+		 * offset in result(Idx), if the window fits in residues.
+		 */
+		template <size_t Idx, typename T, typename Kernel, typename ResultType>
+		void execute_windowed_kernel(const Kernel& kernel,
+			const prostruct::residueVector<T>& residues, size_t offset, ResultType& result)
+		{
+			constexpr size_t window_size = window_size_v<Kernel>;
+			if (offset + window_size <= residues.size())
+				apply(kernel,
+					vector_to_tuple_helper(
+						residues, std::make_index_sequence<window_size> {}, offset),
+					result(Idx));
+		}
+
+		/** The number of residues along each side of a tile of the pairwise engine */
+		constexpr size_t pairwise_tile_size = 64;
+
+		/**
+		 * The first (i, j) of each tile_size x tile_size tile of the upper
+		 * triangle (i <= j) of [first, last) x [first, last).
+		 */
+		inline std::vector<std::pair<size_t, size_t>> upper_triangle_tiles(
+			size_t first, size_t last, size_t tile_size)
+		{
+			std::vector<std::pair<size_t, size_t>> tiles;
+			for (size_t i = first; i < last; i += tile_size)
+			{
+				for (size_t j = i; j < last; j += tile_size)
+					tiles.emplace_back(i, j);
+			}
+			return tiles;
+		}
+
+		template <typename T, typename... Args, size_t... Idx, typename ResultType>
+		void execute_windowed_kernels(const std::tuple<Args...>& kernels,
+			const prostruct::residueVector<T>& residues, size_t offset,
+			std::index_sequence<Idx...>, ResultType&& result)
+		{
+			(execute_windowed_kernel<Idx>(std::get<Idx>(kernels), residues, offset, result), ...);
+		}
+	}
+
 	/**
 	 * A near zero cost abstraction engine to execute multiple lambdas
 	 * per residue in a loop.
+	 * The lambdas can take windows of different sizes, e.g. phi (residue and
+	 * next residue) and chi1 (residue), so that they are all computed in a
+	 * single pass. Each lambda runs on every residue where its window fits, and
+	 * its result is 0 for the last residues where it does not.
 	 *
 	 */
 	template <typename T, typename... Args>
@@ -49,7 +109,15 @@ namespace prostruct::core
 		}
 		else
 		{
-			static_assert(utils::lambdas_have_same_arity<Args...>(), "Not implemented yet!");
+			// the loop runs over the windows of the smallest kernel, and the
+			// larger kernels skip the residues where their window does not fit
+			constexpr size_t min_window_size = std::min({ detail::window_size_v<Args>... });
+#pragma omp parallel for
+			for (size_t i = start; i < residues.size() - min_window_size + 1; ++i)
+			{
+				detail::execute_windowed_kernels(comp, residues, i - start,
+					std::index_sequence_for<Args...> {}, result.col(i - start));
+			}
 		}
 
 		return result;
@@ -87,21 +155,34 @@ namespace prostruct::core
 				window_displacement = 1;
 			if constexpr (is_symmmetric::value)
 			{
-#pragma omp parallel for
-				for (size_t i = start; i < residues.size() - window_size + 1; ++i)
+				// the upper triangle is split in square tiles that all take about the
+				// same time (the tiles on the diagonal half of it), so that the threads
+				// get the same amount of work, and each tile only touches
+				// 2 x pairwise_tile_size residues. The tiles are disjoint, so the mirror
+				// (j, i) of each pair is written by the tile that computes (i, j)
+				const size_t n_windows = residues.size() - window_size + 1;
+				const auto tiles
+					= detail::upper_triangle_tiles(start, n_windows, detail::pairwise_tile_size);
+#pragma omp parallel for schedule(dynamic)
+				for (size_t tile = 0; tile < tiles.size(); ++tile)
 				{
-					for (size_t j = i + window_displacement; j < residues.size() - window_size + 1;
-						 ++j)
+					const auto [first_i, first_j] = tiles[tile];
+					const size_t last_i = std::min(first_i + detail::pairwise_tile_size, n_windows);
+					const size_t last_j = std::min(first_j + detail::pairwise_tile_size, n_windows);
+					for (size_t i = first_i; i < last_i; ++i)
 					{
-						execute_tuple(comp,
-							vector_to_tuple_helper(residues,
-								std::make_index_sequence<window_size> {}, i - start, j - start),
-							result.tube(i, j));
+						for (size_t j = std::max(first_j, i + window_displacement); j < last_j; ++j)
+						{
+							execute_tuple(comp,
+								vector_to_tuple_helper(residues,
+									std::make_index_sequence<window_size> {}, i - start,
+									j - start),
+								result.tube(i, j));
+							for (arma::uword k = 0; k < n_computations; ++k)
+								result.at(j, i, k) = result.at(i, j, k);
+						}
 					}
 				}
-				for (arma::uword k = 0; k < n_computations; ++k) {
-					result.slice(k) = arma::symmatu(result.slice(k));
-				}
 			}
 			else
 			{
@@ -127,6 +208,94 @@ namespace prostruct::core
 		return result;
 	}
 
+	/**
+	 * The result of sparse_pairwise_residue_kernel_engine: the pairs of residues
+	 * that were compared and the result of each computation for each pair.
+	 */
+	template <typename T>
+	struct SparsePairwiseResult
+	{
+		arma::Mat<arma::uword> pairs; /**< 2 x n_pairs, the residues i < j of each pair */
+		arma::Mat<T> values; /**< n_computations x n_pairs */
+	};
+
+	/**
+	 * A pairwise_residue_kernel_engine (symmetric, without the diagonal) for
+	 * kernels that only matter for residues with atoms closer than cutoff, e.g.
+	 * contacts. Each residue is bounded by a sphere (its centroid and the distance
+	 * to its furthest atom) and only the pairs of residues whose spheres are
+	 * closer than cutoff are computed. These are found with a cell list, so time
+	 * and memory are linear in the number of residues rather than the
+	 * n_residues x n_residues x n_computations Cube of the dense engine.
+	 *
+	 */
+	template <typename T, typename... Args>
+	SparsePairwiseResult<T> sparse_pairwise_residue_kernel_engine(
+		const prostruct::residueVector<T>& residues, T cutoff, Args... computations)
+	{
+		static_assert(((utils::lambda_properties<std::decay_t<Args>>::size == 2) && ...),
+			"The kernels of the sparse pairwise engine take two residues.");
+
+		constexpr arma::uword n_computations = sizeof...(computations);
+		const arma::uword n_residues = residues.size();
+		std::tuple<Args...> comp { computations... };
+
+		// bounding sphere of each residue
+		arma::Mat<T> centroids(3, n_residues);
+		arma::Col<T> radii(n_residues);
+#pragma omp parallel for
+		for (arma::uword i = 0; i < n_residues; ++i)
+		{
+			const arma::Mat<T>& xyz = residues[i]->xyz_ref();
+			T* centroid = centroids.colptr(i);
+			centroid[0] = centroid[1] = centroid[2] = 0;
+			for (arma::uword atom = 0; atom < xyz.n_cols; ++atom)
+			{
+				for (arma::uword k = 0; k < 3; ++k)
+					centroid[k] += xyz.at(k, atom) / xyz.n_cols;
+			}
+
+			T radius_squared = 0;
+			for (arma::uword atom = 0; atom < xyz.n_cols; ++atom)
+			{
+				const T dx = xyz.at(0, atom) - centroid[0];
+				const T dy = xyz.at(1, atom) - centroid[1];
+				const T dz = xyz.at(2, atom) - centroid[2];
+				radius_squared = std::max(radius_squared, dx * dx + dy * dy + dz * dz);
+			}
+			radii[i] = std::sqrt(radius_squared);
+		}
+
+		const auto neighbours = geometry::neighbour_list(centroids, radii, cutoff);
+
+		// the neighbours j > i of each residue i, as the result of the dense engine
+		// is symmetric
+		auto upper_neighbours = [&neighbours](arma::uword i) {
+			return std::upper_bound(neighbours.begin(i), neighbours.end(i), i);
+		};
+		std::vector<arma::uword> offsets(n_residues + 1, 0);
+		for (arma::uword i = 0; i < n_residues; ++i)
+			offsets[i + 1] = offsets[i] + (neighbours.end(i) - upper_neighbours(i));
+
+		SparsePairwiseResult<T> result;
+		result.pairs.set_size(2, offsets.back());
+		result.values.zeros(n_computations, offsets.back());
+
+#pragma omp parallel for schedule(dynamic, 64)
+		for (arma::uword i = 0; i < n_residues; ++i)
+		{
+			arma::uword pair = offsets[i];
+			for (auto j = upper_neighbours(i); j != neighbours.end(i); ++j, ++pair)
+			{
+				result.pairs.at(0, pair) = i;
+				result.pairs.at(1, pair) = *j;
+				execute_tuple(comp, std::forward_as_tuple(residues[i], residues[*j]),
+					result.values.col(pair));
+			}
+		}
+
+		return result;
+	}
 }
 
 #endif // PROSTRUCT_ENGINE_H
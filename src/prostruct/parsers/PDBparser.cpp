@@ -8,91 +8,129 @@
 
 #include <prostruct/parsers/PDBparser.h>
 
-#include <cstdio>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <utility>
 
 using namespace prostruct;
 
-inline void remove_whitespace(std::string& str)
+namespace prostruct::parsers
 {
-	str.erase(std::remove_if(str.begin(), str.end(), isspace), str.end());
-}
-
-template <typename T>
-inline T scalar_from_buffer(const std::string& buffer)
-{
-	return std::stod(buffer);
-}
-
-template <>
-inline float scalar_from_buffer(const std::string& buffer)
-{
-	return std::stof(buffer);
-}
-
-template <typename T>
-void createMap(const std::string& fname,
-	std::map<std::string, std::map<std::string, atomVector<T>, AASequenceOrder>>& chainResMap,
-	std::vector<std::string>& chainOrder)
-{
-
-	std::ifstream file(fname);
-
-	std::string line;
-
-	if (!file.is_open())
-		throw "File does not exist!";
-
-	while (std::getline(file, line))
+	template <typename T>
+	ParsedStructure<T> parse_pdb(const std::string& filename, bool all_models)
 	{
+		return parse_pdb<T>(MappedFile(filename), all_models);
+	}
 
-		auto record = line.substr(0, 5);
-
-		remove_whitespace(record);
-
-		if (record == "ATOM")
-		{
+	template <typename T>
+	ParsedStructure<T> parse_pdb(MappedFile file, bool all_models)
+	{
+		// the whole file is mapped and decoded in place, so the records only
+		// hold views into the mapping and no strings are created per atom
+		ParsedStructure<T> structure { std::move(file), {}, {}, {} };
+
+		// ATOM records are usually 80 columns wide, so this estimates the number of
+		// atoms. It is not a bound: short or truncated lines make the vector grow,
+		// and files with many other records reserve more than they need
+		structure.atoms.reserve(structure.file.size() / 80 + 1);
+
+		std::string_view last_chain;
+		std::uint32_t last_chain_index = 0;
+
+		// the atoms of the first model make the topology, the atoms of the
+		// other models only need their coordinates
+		size_t model = 0;
+		size_t atoms_in_model = 0;
+
+		auto end_model = [&]() {
+			if (atoms_in_model == 0)
+				return;
+			if (model > 0 && atoms_in_model != structure.atoms.size())
+				throw "Model " + std::to_string(model + 1) + " has "
+					+ std::to_string(atoms_in_model) + " atoms, expected "
+					+ std::to_string(structure.atoms.size());
+			++model;
+			atoms_in_model = 0;
+		};
+
+		for_each_line(structure.file.view(), [&](std::string_view line) {
+			// the lines after the first model are skipped unless all the models are read
+			if (model > 0 && !all_models)
+				return;
+			if (is_end_model_record(line))
+			{
+				end_model();
+				return;
+			}
+			if (!is_atom_record(line))
+				return;
 
-			auto serialStr = line.substr(6, 5);
-			//            int serial = std::stoi(serialStr);
-			auto name = line.substr(12, 4);
-			//            auto altLocation = line.at(16);
-			auto residue = line.substr(17, 3);
-			auto chainID = line.substr(21, 1);
-			auto resSeqStr = line.substr(22, 4);
-			//            int resSeq = std::stoi(resSeqStr);
-			auto insCode = line.substr(26, 1);
-			T x = scalar_from_buffer<T>(line.substr(30, 8));
-			T y = scalar_from_buffer<T>(line.substr(38, 8));
-			T z = scalar_from_buffer<T>(line.substr(46, 8));
-			//            double occupancy = std::stod(line.substr(54, 6));
-			//            double tempFactor = std::stod(line.substr(60, 6));
-			std::string element = line.substr(76, 2);
-			//            auto charge = line.substr(78, 2);
-
-			remove_whitespace(name);
-			remove_whitespace(serialStr);
-			remove_whitespace(element);
-			remove_whitespace(resSeqStr);
-			remove_whitespace(insCode);
-
-			if (std::find(chainOrder.begin(), chainOrder.end(), chainID) == chainOrder.end())
+			++atoms_in_model;
+			if (model > 0)
 			{
-				chainOrder.push_back(chainID);
+				if (atoms_in_model > structure.atoms.size())
+					throw "Model " + std::to_string(model + 1)
+						+ " has more atoms than the first model";
+				// reserved at the first atom of the second model, so that single model
+				// files do not pay for it, estimating the atoms left as above
+				if (structure.model_xyz.empty())
+				{
+					const size_t remaining = structure.file.size()
+						- static_cast<size_t>(line.data() - structure.file.view().data());
+					structure.model_xyz.reserve(3 * (remaining / 80 + 1));
+				}
+				structure.model_xyz.insert(structure.model_xyz.end(),
+					{ scalar_from_chars<T>(column(line, 30, 8)),
+						scalar_from_chars<T>(column(line, 38, 8)),
+						scalar_from_chars<T>(column(line, 46, 8)) });
+				return;
 			}
 
-			auto residueID = residue + "-" + resSeqStr + "-" + insCode;
-			chainResMap[chainID][residueID].emplace_back(
-				std::make_shared<Atom<T>>(element, name, x, y, z));
+			auto record = decode_atom_record<T>(line);
+			// atoms of a chain are almost always contiguous, so only search the
+			// chain list when the chain changes
+			if (structure.chain_order.empty() || record.chain_id != last_chain)
+			{
+				auto chain = std::find(
+					structure.chain_order.begin(), structure.chain_order.end(), record.chain_id);
+				if (chain == structure.chain_order.end())
+					chain = structure.chain_order.emplace(chain, record.chain_id);
+				last_chain = record.chain_id;
+				last_chain_index
+					= static_cast<std::uint32_t>(std::distance(structure.chain_order.begin(), chain));
+			}
+			record.chain_index = last_chain_index;
+			record.file_index = structure.atoms.size();
+			structure.atoms.push_back(record);
+		});
+		// the last model of files without a final ENDMDL
+		end_model();
+		structure.n_models = std::max<size_t>(model, 1);
+
+		auto residue_order = [](const AtomRecord<T>& left, const AtomRecord<T>& right) {
+			return left.chain_index < right.chain_index
+				|| (left.chain_index == right.chain_index && left.residue_key < right.residue_key);
+		};
+
+		// well formed files are already in order, in which case this is a single linear scan.
+		// Otherwise sort once, keeping the file order of the atoms within each residue
+		if (!std::is_sorted(structure.atoms.begin(), structure.atoms.end(), residue_order))
+			std::stable_sort(structure.atoms.begin(), structure.atoms.end(), residue_order);
+
+		for (size_t i = 0; i < structure.atoms.size(); ++i)
+		{
+			const auto& atom = structure.atoms[i];
+			if (structure.residues.empty()
+				|| structure.residues.back().chain_index != atom.chain_index
+				|| structure.residues.back().residue_key != atom.residue_key)
+				structure.residues.push_back({ atom.chain_index, atom.residue_key, i, 0 });
+			++structure.residues.back().n_atoms;
 		}
-	}
-}
 
-template void createMap(const std::string&,
-	std::map<std::string, std::map<std::string, atomVector<float>, AASequenceOrder>>&,
-	std::vector<std::string>&);
+		return structure;
+	}
 
-template void createMap(const std::string&,
-	std::map<std::string, std::map<std::string, atomVector<double>, AASequenceOrder>>&,
-	std::vector<std::string>&);
+	template ParsedStructure<float> parse_pdb(const std::string&, bool);
+	template ParsedStructure<double> parse_pdb(const std::string&, bool);
+	template ParsedStructure<float> parse_pdb(MappedFile, bool);
+	template ParsedStructure<double> parse_pdb(MappedFile, bool);
+}
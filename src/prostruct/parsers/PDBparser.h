@@ -9,43 +9,213 @@
 #ifndef PROSTRUCT_PDBPARSER_H
 #define PROSTRUCT_PDBPARSER_H
 
+#include <prostruct/parsers/mapped_file.h>
 #include <prostruct/struct/atom.h>
 #include <prostruct/struct/utils.h>
 
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
 
 using namespace prostruct;
 
-struct AASequenceOrder
+namespace prostruct::parsers
+{
+	/**
+	 * Residue sequence number and insertion code packed into a single integer,
+	 * so that residues are ordered by number first and then by insertion code,
+	 * with the non insertion residue first, i.e. ALA1 < ALA1A < ALA1B < ALA2.
+	 */
+	using residue_key_t = std::int64_t;
+
+	inline residue_key_t make_residue_key(int residue_sequence, char insertion_code) noexcept
+	{
+		return static_cast<residue_key_t>(residue_sequence) * 256
+			+ static_cast<unsigned char>(insertion_code == ' ' ? '\0' : insertion_code);
+	}
+
+	/**
+	 * A decoded ATOM record. All the string fields are views into the
+	 * (memory mapped) file buffer, with the PDB column padding removed.
+	 */
+	template <typename T>
+	struct AtomRecord
+	{
+		std::string_view name;
+		std::string_view residue_name;
+		std::string_view chain_id;
+		std::string_view residue_sequence;
+		std::string_view insertion_code;
+		std::string_view element;
+		T x, y, z;
+		std::uint32_t chain_index;
+		residue_key_t residue_key;
+		size_t file_index; /**< position of the record among the atoms of its model */
+	};
+
+	inline std::string_view trim(std::string_view field) noexcept
+	{
+		while (!field.empty() && field.front() == ' ')
+			field.remove_prefix(1);
+		while (!field.empty() && field.back() == ' ')
+			field.remove_suffix(1);
+		return field;
+	}
+
+	/**
+	 * Returns the fixed width PDB column [pos, pos + len), clamped to the
+	 * line length, since trailing columns are often omitted.
+	 */
+	inline std::string_view column(std::string_view line, size_t pos, size_t len) noexcept
+	{
+		if (pos >= line.size())
+			return {};
+		return line.substr(pos, len);
+	}
+
+	template <typename T>
+	inline T scalar_from_chars(std::string_view field)
+	{
+		field = trim(field);
+		T value;
+		auto [ptr, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+		if (error != std::errc() || ptr != field.data() + field.size())
+			throw "Could not parse coordinate: " + std::string(field);
+		return value;
+	}
+
+	inline int integer_from_chars(std::string_view field)
+	{
+		field = trim(field);
+		int value = 0;
+		auto [ptr, error] = std::from_chars(field.data(), field.data() + field.size(), value);
+		if (error != std::errc() || ptr != field.data() + field.size())
+			throw "Could not parse residue number: " + std::string(field);
+		return value;
+	}
+
+	template <typename T>
+	inline AtomRecord<T> decode_atom_record(std::string_view line)
+	{
+		AtomRecord<T> record;
+		record.name = trim(column(line, 12, 4));
+		record.residue_name = column(line, 17, 3);
+		record.chain_id = column(line, 21, 1);
+		record.residue_sequence = trim(column(line, 22, 4));
+		record.insertion_code = trim(column(line, 26, 1));
+		record.x = scalar_from_chars<T>(column(line, 30, 8));
+		record.y = scalar_from_chars<T>(column(line, 38, 8));
+		record.z = scalar_from_chars<T>(column(line, 46, 8));
+		record.element = trim(column(line, 76, 2));
+		record.chain_index = 0;
+		record.file_index = 0;
+		record.residue_key = make_residue_key(integer_from_chars(record.residue_sequence),
+			record.insertion_code.empty() ? ' ' : record.insertion_code.front());
+		return record;
+	}
+
+	inline bool is_atom_record(std::string_view line) noexcept
+	{
+		return line.size() >= 4 && line.compare(0, 4, "ATOM") == 0
+			&& (line.size() == 4 || line[4] == ' ');
+	}
+
+	/** ENDMDL closes a MODEL of a multi-model (NMR or ensemble) file */
+	inline bool is_end_model_record(std::string_view line) noexcept
+	{
+		return line.size() >= 6 && line.compare(0, 6, "ENDMDL") == 0;
+	}
+
+	/**
+	 * Walks a PDB buffer and calls callback(std::string_view) for every line,
+	 * without the line ending. No memory is allocated while scanning.
+	 */
+	template <typename Callback>
+	void for_each_line(std::string_view buffer, Callback&& callback)
+	{
+		const char* position = buffer.data();
+		const char* end = buffer.data() + buffer.size();
+
+		while (position < end)
+		{
+			auto line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+			if (line_end == nullptr)
+				line_end = end;
+
+			std::string_view line(position, line_end - position);
+			if (!line.empty() && line.back() == '\r')
+				line.remove_suffix(1);
+
+			callback(line);
+
+			position = line_end + 1;
+		}
+	}
+
+	/**
+	 * Walks a PDB buffer line by line and calls callback(AtomRecord<T>) for
+	 * every ATOM record. No memory is allocated while scanning.
+	 */
+	template <typename T, typename Callback>
+	void for_each_atom_record(std::string_view buffer, Callback&& callback)
+	{
+		for_each_line(buffer, [&callback](std::string_view line) {
+			if (is_atom_record(line))
+				callback(decode_atom_record<T>(line));
+		});
+	}
+}
+
+namespace prostruct::parsers
 {
-	bool operator()(const std::string& left, const std::string& right) const
-	{
-		std::string::size_type p_r = right.find('-');
-		std::string::size_type pp_r = right.find('-', p_r + 1);
-		auto right_str = right.substr(p_r + 1, pp_r - p_r - 1);
-		int right_int = std::stoi(right_str);
-
-		std::string::size_type p_l = left.find('-');
-		std::string::size_type pp_l = left.find('-', p_l + 1);
-		auto left_str = left.substr(p_l + 1, pp_l - p_l - 1);
-		int left_int = std::stoi(left_str);
-
-		if (pp_r + 1 == right.size() && pp_l + 1 == left.size())
-			return right_int > left_int; // compare non-insertions -> ALA2 > ALA1
-		else if (pp_r + 1 < right.size() && pp_l + 1 == left.size() && right_int == left_int)
-			return true; // compare non-insertion with insertion -> ALA1A > ALA1
-		else if (pp_l + 1 < left.size() && pp_r + 1 == right.size() && right_int == left_int)
-			return false; // compare insertion with non-insertion -> ALA1 > ALA1A
-		else if (pp_l + 1 < left.size() && pp_r + 1 < right.size() && right_int == left_int)
-			return right.substr(pp_r + 1, right.npos)
-				> left.substr(pp_l + 1, left.npos); // compare insertions -> ALA2A > ALA2A
-		else
-			return right_int > left_int;
-	}
-};
-
-template <typename T>
-void createMap(const std::string&,
-	std::map<std::string, std::map<std::string, atomVector<T>, AASequenceOrder>>&,
-	std::vector<std::string>&);
+	/**
+	 * A contiguous run of atoms in ParsedStructure::atoms that belong to the
+	 * same residue.
+	 */
+	struct ResidueRange
+	{
+		std::uint32_t chain_index;
+		residue_key_t residue_key;
+		size_t first_atom;
+		size_t n_atoms;
+	};
+
+	/**
+	 * The ATOM records of a PDB file grouped by chain and residue.
+	 * The records are views into the mapped file, which is kept alive here.
+	 * The topology (and the first set of coordinates) comes from the first
+	 * model of multi-model files, the other models only add coordinates, and
+	 * only if they are requested (see parse_pdb).
+	 */
+	template <typename T>
+	struct ParsedStructure
+	{
+		MappedFile file;
+		std::vector<std::string> chain_order; /**< chain names in order of appearance */
+		std::vector<AtomRecord<T>> atoms; /**< sorted by chain and then residue key */
+		std::vector<ResidueRange> residues; /**< residues in chain/sequence order */
+		size_t n_models = 1; /**< the number of models read */
+		/**
+		 * x, y and z of the atoms of the models after the first, model by model,
+		 * with the atoms of each model in file order (see AtomRecord::file_index).
+		 * Empty unless all the models are read.
+		 */
+		std::vector<T> model_xyz;
+	};
+
+	/**
+	 * Parses the first model of filename, or with all_models (e.g. for an
+	 * Ensemble) also the coordinates of the other models. A PDB only keeps the
+	 * first model, so it does not pay for the others.
+	 */
+	template <typename T>
+	ParsedStructure<T> parse_pdb(const std::string& filename, bool all_models = false);
+
+	/** Parses a file that is already mapped, the result keeps the mapping */
+	template <typename T>
+	ParsedStructure<T> parse_pdb(MappedFile file, bool all_models = false);
+}
 
 #endif // PROSTRUCT_PDBPARSER_H
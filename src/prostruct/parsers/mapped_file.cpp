@@ -0,0 +1,91 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/parsers/mapped_file.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+using namespace prostruct::parsers;
+
+MappedFile::MappedFile(const std::string& filename)
+{
+	int fd = ::open(filename.c_str(), O_RDONLY);
+
+	if (fd == -1)
+		throw "File does not exist!";
+
+	struct stat file_stats;
+	if (::fstat(fd, &file_stats) == -1)
+	{
+		::close(fd);
+		throw "Could not stat file!";
+	}
+
+	m_size = static_cast<std::size_t>(file_stats.st_size);
+
+	// mmap does not accept zero length mappings, an empty file is just an empty view
+	if (m_size > 0)
+	{
+		void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			throw "Could not memory map file!";
+		}
+		// the file is scanned front to back exactly once
+		::madvise(data, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(data);
+	}
+
+	// the mapping keeps its own reference to the file
+	::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: m_data(std::exchange(other.m_data, nullptr))
+	, m_size(std::exchange(other.m_size, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		m_data = std::exchange(other.m_data, nullptr);
+		m_size = std::exchange(other.m_size, 0);
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile() { release(); }
+
+void MappedFile::prefetch() const noexcept
+{
+	if (m_data == nullptr)
+		return;
+
+	::madvise(const_cast<char*>(m_data), m_size, MADV_WILLNEED);
+	// madvise is only a hint, reading a byte of every page waits for the page
+	const std::size_t page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+	for (std::size_t offset = 0; offset < m_size; offset += page_size)
+		static_cast<void>(*static_cast<const volatile char*>(m_data + offset));
+}
+
+void MappedFile::release() noexcept
+{
+	if (m_data != nullptr)
+		::munmap(const_cast<char*>(m_data), m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
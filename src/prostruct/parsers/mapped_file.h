@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_MAPPED_FILE_H
+#define PROSTRUCT_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace prostruct::parsers
+{
+	/**
+	 * Read-only memory mapping of a whole file.
+	 * The mapping is released when the object goes out of scope, so any
+	 * std::string_view obtained from view() must not outlive it.
+	 */
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(const std::string& filename);
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		~MappedFile();
+
+		std::string_view view() const noexcept { return { m_data, m_size }; }
+
+		std::size_t size() const noexcept { return m_size; }
+
+		/**
+		 * Reads the whole file into memory now, rather than page by page while
+		 * it is scanned, e.g. to do the I/O in another thread than the decoding.
+		 */
+		void prefetch() const noexcept;
+
+	private:
+		void release() noexcept;
+
+		const char* m_data = nullptr;
+		std::size_t m_size = 0;
+	};
+}
+
+#endif // PROSTRUCT_MAPPED_FILE_H
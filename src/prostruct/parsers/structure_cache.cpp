@@ -0,0 +1,169 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/parsers/structure_cache.h>
+
+#include <cstring>
+#include <fstream>
+
+using namespace prostruct::parsers;
+
+namespace
+{
+	constexpr size_t align(size_t offset) noexcept { return (offset + 7) & ~size_t { 7 }; }
+
+	/** The offset of each section from the start of the file */
+	struct Layout
+	{
+		size_t xyz;
+		size_t radii;
+		size_t names;
+		size_t elements;
+		size_t table_positions;
+		size_t residues;
+		size_t chains;
+		size_t strings;
+		size_t end;
+	};
+
+	Layout layout(const StructureCacheHeader& header) noexcept
+	{
+		const size_t n_atoms = header.n_atoms;
+		Layout result;
+		result.xyz = align(sizeof(StructureCacheHeader));
+		result.radii = align(result.xyz + 3 * n_atoms * header.scalar_size);
+		result.names = align(result.radii + n_atoms * header.scalar_size);
+		result.elements = align(result.names + n_atoms * sizeof(std::uint32_t));
+		result.table_positions = align(result.elements + n_atoms * sizeof(std::uint8_t));
+		result.residues = align(result.table_positions + n_atoms * sizeof(std::uint64_t));
+		result.chains = align(result.residues + header.n_residues * sizeof(CachedResidue));
+		result.strings = align(result.chains + header.n_chains * sizeof(CachedChain));
+		result.end = align(result.strings + header.strings_size);
+		return result;
+	}
+}
+
+std::uint64_t prostruct::parsers::structure_cache_checksum(const char* data, size_t size) noexcept
+{
+	constexpr std::uint64_t prime = 1099511628211ULL;
+	std::uint64_t hash = 14695981039346656037ULL;
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		hash = (hash ^ word) * prime;
+	}
+	for (; i < size; ++i)
+		hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+	return hash;
+}
+
+std::uint32_t StringTable::add(std::string_view value)
+{
+	auto [position, inserted] = m_offsets.try_emplace(
+		std::string(value), static_cast<std::uint32_t>(m_data.size()));
+	if (inserted)
+	{
+		m_data.append(value);
+		m_data.push_back('\0');
+	}
+	return position->second;
+}
+
+void prostruct::parsers::write_structure_cache(
+	const std::string& filename, std::uint64_t n_atoms, const StructureCacheSections& sections)
+{
+	StructureCacheHeader header {};
+	std::memcpy(header.magic, structure_cache_magic, sizeof(header.magic));
+	header.version = structure_cache_version;
+	header.byte_order = structure_cache_byte_order;
+	header.scalar_size = sections.scalar_size;
+	header.source = sections.source;
+	header.n_atoms = n_atoms;
+	header.n_residues = sections.residues.size();
+	header.n_chains = sections.chains.size();
+	header.strings_size = sections.strings.data().size();
+
+	const Layout offsets = layout(header);
+	// the sections are assembled in memory (with zeros in the padding) to
+	// compute their checksum before the header is written
+	std::vector<char> buffer(offsets.end - offsets.xyz, 0);
+	auto copy = [&buffer, &offsets](size_t offset, const void* data, size_t size) {
+		if (size > 0)
+			std::memcpy(buffer.data() + offset - offsets.xyz, data, size);
+	};
+	copy(offsets.xyz, sections.xyz, 3 * n_atoms * sections.scalar_size);
+	copy(offsets.radii, sections.radii, n_atoms * sections.scalar_size);
+	copy(offsets.names, sections.names, n_atoms * sizeof(std::uint32_t));
+	copy(offsets.elements, sections.elements, n_atoms * sizeof(std::uint8_t));
+	copy(offsets.table_positions, sections.table_positions.data(),
+		n_atoms * sizeof(std::uint64_t));
+	copy(offsets.residues, sections.residues.data(),
+		sections.residues.size() * sizeof(CachedResidue));
+	copy(offsets.chains, sections.chains.data(), sections.chains.size() * sizeof(CachedChain));
+	copy(offsets.strings, sections.strings.data().data(), sections.strings.data().size());
+	header.checksum = structure_cache_checksum(buffer.data(), buffer.size());
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		throw "Could not open file for writing: " + filename;
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	const std::vector<char> header_padding(offsets.xyz - sizeof(header), 0);
+	file.write(header_padding.data(), header_padding.size());
+	file.write(buffer.data(), buffer.size());
+	if (!file)
+		throw "Could not write structure cache: " + filename;
+}
+
+StructureCache::StructureCache(const std::string& filename)
+	: m_file(filename)
+{
+	const char* data = m_file.view().data();
+	if (m_file.size() < sizeof(StructureCacheHeader))
+		throw "Not a structure cache: " + filename;
+	std::memcpy(&m_header, data, sizeof(m_header));
+
+	if (std::memcmp(m_header.magic, structure_cache_magic, sizeof(m_header.magic)) != 0)
+		throw "Not a structure cache: " + filename;
+	if (m_header.version != structure_cache_version)
+		throw "Unsupported structure cache version " + std::to_string(m_header.version) + ": "
+			+ filename;
+	if (m_header.byte_order != structure_cache_byte_order)
+		throw "Structure cache written with another byte order: " + filename;
+	if (m_header.scalar_size != sizeof(float) && m_header.scalar_size != sizeof(double))
+		throw "Corrupt structure cache: " + filename;
+
+	const Layout offsets = layout(m_header);
+	if (offsets.end != m_file.size())
+		throw "Truncated structure cache: " + filename;
+	if (structure_cache_checksum(data + offsets.xyz, offsets.end - offsets.xyz)
+		!= m_header.checksum)
+		throw "Structure cache checksum mismatch: " + filename;
+
+	m_xyz = data + offsets.xyz;
+	m_radii = data + offsets.radii;
+	m_names = reinterpret_cast<const std::uint32_t*>(data + offsets.names);
+	m_elements = reinterpret_cast<const std::uint8_t*>(data + offsets.elements);
+	m_table_positions = reinterpret_cast<const std::uint64_t*>(data + offsets.table_positions);
+	m_residues = reinterpret_cast<const CachedResidue*>(data + offsets.residues);
+	m_chains = reinterpret_cast<const CachedChain*>(data + offsets.chains);
+	m_strings = std::string_view(data + offsets.strings, m_header.strings_size);
+}
+
+std::string_view StructureCache::string(std::uint32_t offset) const
+{
+	if (offset >= m_strings.size())
+		throw "Corrupt structure cache: string out of range";
+	// the writer ends every string with a null character
+	const auto end = m_strings.find('\0', offset);
+	if (end == std::string_view::npos)
+		throw "Corrupt structure cache: unterminated string";
+	return m_strings.substr(offset, end - offset);
+}
@@ -0,0 +1,165 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_STRUCTURE_CACHE_H
+#define PROSTRUCT_STRUCTURE_CACHE_H
+
+#include <prostruct/parsers/mapped_file.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace prostruct::parsers
+{
+	/**
+	 * The binary structure cache is a snapshot of the AtomTable, residues and
+	 * chains of a PDB, written so that it can be loaded from a single memory
+	 * mapping: a StructureCacheHeader followed by these sections, each aligned
+	 * to 8 bytes
+	 * - xyz: 3 x n_atoms coordinates (float or double, see scalar_size)
+	 * - radii: n_atoms radii (float or double)
+	 * - names: n_atoms packed atom names (see pack_atom_name)
+	 * - elements: n_atoms atomic numbers
+	 * - table_positions: n_atoms positions in the table of the atoms in file order
+	 * - residues: n_residues CachedResidue
+	 * - chains: n_chains CachedChain
+	 * - strings: the null terminated strings the residues and chains refer to,
+	 *   each stored once
+	 * The sections are in the byte order of the machine that wrote the file.
+	 */
+	struct StructureCacheHeader
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byte_order; /**< structure_cache_byte_order as written */
+		std::uint32_t scalar_size; /**< size of the coordinates and radii, 4 or 8 */
+		std::uint32_t source; /**< offset in strings of the name of the parsed file */
+		std::uint64_t n_atoms;
+		std::uint64_t n_residues;
+		std::uint64_t n_chains;
+		std::uint64_t strings_size;
+		std::uint64_t checksum; /**< structure_cache_checksum of the sections */
+	};
+
+	struct CachedResidue
+	{
+		std::uint64_t first_atom;
+		std::uint32_t n_atoms;
+		std::uint32_t chain_index;
+		std::uint32_t amino_acid_name; /**< offset in strings, e.g. ALA */
+		std::uint32_t residue_name; /**< offset in strings, e.g. ALA-1- */
+		std::uint32_t amino_acid; /**< the AminoAcid */
+		std::uint32_t padding;
+	};
+
+	struct CachedChain
+	{
+		std::uint64_t first_residue;
+		std::uint64_t n_residues;
+		std::uint32_t name; /**< offset in strings */
+		std::uint32_t padding;
+	};
+
+	constexpr char structure_cache_magic[8] = { 'P', 'S', 'C', 'A', 'C', 'H', 'E', '\0' };
+	constexpr std::uint32_t structure_cache_version = 1;
+	constexpr std::uint32_t structure_cache_byte_order = 0x01020304;
+
+	/** 64 bit FNV-1a of data, eight bytes at a time */
+	std::uint64_t structure_cache_checksum(const char* data, size_t size) noexcept;
+
+	/** The strings of a structure cache, each stored once */
+	class StringTable
+	{
+	public:
+		/** The offset of value in the table, adding it if it is new */
+		std::uint32_t add(std::string_view value);
+
+		const std::string& data() const noexcept { return m_data; }
+
+	private:
+		std::string m_data;
+		std::unordered_map<std::string, std::uint32_t> m_offsets;
+	};
+
+	/**
+	 * The sections of a structure cache to write. The pointers are to arrays
+	 * of n_atoms (or 3 x n_atoms for xyz) values of scalar_size bytes.
+	 */
+	struct StructureCacheSections
+	{
+		std::uint32_t scalar_size;
+		const void* xyz;
+		const void* radii;
+		const std::uint32_t* names;
+		const std::uint8_t* elements;
+		std::vector<std::uint64_t> table_positions;
+		std::vector<CachedResidue> residues;
+		std::vector<CachedChain> chains;
+		StringTable strings;
+		std::uint32_t source;
+	};
+
+	void write_structure_cache(
+		const std::string& filename, std::uint64_t n_atoms, const StructureCacheSections& sections);
+
+	/**
+	 * A memory mapped structure cache. The constructor checks the header and
+	 * the checksum, and throws if the file is not a valid structure cache.
+	 * The sections are read in place, and are valid while the cache is.
+	 */
+	class StructureCache
+	{
+	public:
+		explicit StructureCache(const std::string& filename);
+
+		const StructureCacheHeader& header() const noexcept { return m_header; }
+
+		std::uint64_t n_atoms() const noexcept { return m_header.n_atoms; }
+		std::uint64_t n_residues() const noexcept { return m_header.n_residues; }
+		std::uint64_t n_chains() const noexcept { return m_header.n_chains; }
+
+		/** The coordinates and radii have this type, which is float or double */
+		template <typename U>
+		const U* xyz() const noexcept
+		{
+			return reinterpret_cast<const U*>(m_xyz);
+		}
+
+		template <typename U>
+		const U* radii() const noexcept
+		{
+			return reinterpret_cast<const U*>(m_radii);
+		}
+
+		const std::uint32_t* names() const noexcept { return m_names; }
+		const std::uint8_t* elements() const noexcept { return m_elements; }
+		const std::uint64_t* table_positions() const noexcept { return m_table_positions; }
+		const CachedResidue* residues() const noexcept { return m_residues; }
+		const CachedChain* chains() const noexcept { return m_chains; }
+
+		/** The string at offset of the string table */
+		std::string_view string(std::uint32_t offset) const;
+
+	private:
+		MappedFile m_file;
+		StructureCacheHeader m_header;
+		const char* m_xyz;
+		const char* m_radii;
+		const std::uint32_t* m_names;
+		const std::uint8_t* m_elements;
+		const std::uint64_t* m_table_positions;
+		const CachedResidue* m_residues;
+		const CachedChain* m_chains;
+		std::string_view m_strings;
+	};
+}
+
+#endif // PROSTRUCT_STRUCTURE_CACHE_H
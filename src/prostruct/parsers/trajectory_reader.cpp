@@ -0,0 +1,523 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/parsers/trajectory_reader.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+
+using namespace prostruct::parsers;
+
+namespace
+{
+	std::uint32_t byte_swap(std::uint32_t value) noexcept
+	{
+		return ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00)
+			| (value >> 24);
+	}
+
+	/** value as stored in a file with the given byte order */
+	template <typename U>
+	U decode(const char* data, bool swap) noexcept
+	{
+		static_assert(sizeof(U) == 4, "Expected a 4 byte type");
+		std::uint32_t bits;
+		std::memcpy(&bits, data, 4);
+		if (swap)
+			bits = byte_swap(bits);
+		U result;
+		std::memcpy(&result, &bits, 4);
+		return result;
+	}
+
+	bool is_little_endian() noexcept
+	{
+		const std::uint32_t one = 1;
+		unsigned char first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	// xdrfile (xdr3dfcoord) compression tables
+	constexpr std::array<int, 73> magicints { 0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 10, 12, 16, 20, 25,
+		32, 40, 50, 64, 80, 101, 128, 161, 203, 256, 322, 406, 512, 645, 812, 1024, 1290, 1625,
+		2048, 2580, 3250, 4096, 5060, 6501, 8192, 10321, 13003, 16384, 20642, 26007, 32768, 41285,
+		52015, 65536, 82570, 104031, 131072, 165140, 208063, 262144, 330280, 416127, 524287,
+		660561, 832255, 1048576, 1321122, 1664510, 2097152, 2642245, 3329021, 4194304, 5284491,
+		6658042, 8388607, 10568983, 13316085, 16777216 };
+	constexpr int first_index = 9;
+	constexpr int last_index = static_cast<int>(magicints.size());
+
+	/** The number of bits needed to store integers in [0, size) */
+	int size_of_int(std::uint32_t size) noexcept
+	{
+		std::uint64_t num = 1;
+		int num_of_bits = 0;
+		while (size >= num && num_of_bits < 32)
+		{
+			++num_of_bits;
+			num <<= 1;
+		}
+		return num_of_bits;
+	}
+
+	/** The number of bits needed to store three integers in [0, sizes[i]) as one number */
+	int size_of_ints(const std::array<std::uint32_t, 3>& sizes) noexcept
+	{
+		std::array<std::uint32_t, 32> bytes {};
+		bytes[0] = 1;
+		int num_of_bytes = 1;
+		for (std::uint32_t size : sizes)
+		{
+			std::uint64_t tmp = 0;
+			int byte = 0;
+			for (; byte < num_of_bytes; ++byte)
+			{
+				tmp = bytes[byte] * static_cast<std::uint64_t>(size) + tmp;
+				bytes[byte] = tmp & 0xff;
+				tmp >>= 8;
+			}
+			for (; tmp != 0; tmp >>= 8)
+				bytes[byte++] = tmp & 0xff;
+			num_of_bytes = byte;
+		}
+		int num_of_bits = 0;
+		for (std::uint32_t num = 1; bytes[num_of_bytes - 1] >= num; num *= 2)
+			++num_of_bits;
+		return num_of_bits + (num_of_bytes - 1) * 8;
+	}
+
+	/** Reads the bit stream of the compressed coordinates, most significant bit first */
+	class BitReader
+	{
+	public:
+		BitReader(const unsigned char* data, size_t size, const std::string& filename)
+			: m_data(data)
+			, m_size(size)
+			, m_filename(filename)
+		{
+		}
+
+		std::uint32_t read(int n_bits)
+		{
+			while (m_n_bits < n_bits)
+			{
+				if (m_position == m_size)
+					throw "Corrupt XTC frame in " + m_filename;
+				m_bits = (m_bits << 8) | m_data[m_position++];
+				m_n_bits += 8;
+			}
+			m_n_bits -= n_bits;
+			const std::uint64_t result = m_bits >> m_n_bits;
+			m_bits &= (std::uint64_t { 1 } << m_n_bits) - 1;
+			return static_cast<std::uint32_t>(result);
+		}
+
+		/** Reads three integers in [0, sizes[i]) stored as one number of n_bits bits */
+		void read_ints(int n_bits, const std::array<std::uint32_t, 3>& sizes, std::int32_t* nums)
+		{
+			// the number is stored least significant byte first
+			std::array<std::uint32_t, 32> bytes {};
+			int num_of_bytes = 0;
+			for (; n_bits > 8; n_bits -= 8)
+				bytes[num_of_bytes++] = read(8);
+			if (n_bits > 0)
+				bytes[num_of_bytes++] = read(n_bits);
+
+			for (int i = 2; i > 0; --i)
+			{
+				std::uint64_t num = 0;
+				for (int byte = num_of_bytes - 1; byte >= 0; --byte)
+				{
+					num = (num << 8) | bytes[byte];
+					const std::uint64_t quotient = num / sizes[i];
+					bytes[byte] = static_cast<std::uint32_t>(quotient);
+					num -= quotient * sizes[i];
+				}
+				nums[i] = static_cast<std::int32_t>(num);
+			}
+			nums[0] = static_cast<std::int32_t>(
+				bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24));
+		}
+
+	private:
+		const unsigned char* m_data;
+		size_t m_size;
+		size_t m_position = 0;
+		std::uint64_t m_bits = 0;
+		int m_n_bits = 0;
+		const std::string& m_filename;
+	};
+}
+
+TrajectoryReader::TrajectoryReader(const std::string& filename)
+	: m_filename(filename)
+	, m_file(filename, std::ios::binary)
+{
+	if (!m_file)
+		throw "File does not exist!";
+}
+
+bool TrajectoryReader::read_bytes(char* data, size_t size)
+{
+	m_file.read(data, static_cast<std::streamsize>(size));
+	const auto n_read = static_cast<size_t>(m_file.gcount());
+	if (n_read == size)
+		return true;
+	if (n_read == 0)
+		return false;
+	throw "Truncated frame in " + m_filename;
+}
+
+/**
+ * A DCD file is a sequence of Fortran unformatted records, each between two
+ * 4 byte record lengths: a header with the number of frames and the flags of
+ * the optional records, a title, the number of atoms and then, for each frame,
+ * an optional unit cell and the x, y and z coordinates of all atoms.
+ */
+DCDReader::DCDReader(const std::string& filename)
+	: TrajectoryReader(filename)
+{
+	char header[92];
+	if (!read_bytes(header, sizeof(header)))
+		throw "Empty DCD file: " + filename;
+
+	// the first record is 84 bytes long, which tells the byte order of the file
+	if (decode<std::int32_t>(header, false) == 84)
+		m_swap = false;
+	else if (decode<std::int32_t>(header, true) == 84)
+		m_swap = true;
+	else
+		throw "Not a DCD file (or a 64 bit record DCD file): " + filename;
+
+	if (std::memcmp(header + 4, "CORD", 4) != 0)
+		throw "Not a coordinate DCD file: " + filename;
+
+	// the 20 integers after "CORD"
+	const char* icntrl = header + 8;
+	const auto fixed_atoms = decode<std::int32_t>(icntrl + 4 * 8, m_swap);
+	const auto charmm_version = decode<std::int32_t>(icntrl + 4 * 19, m_swap);
+	if (charmm_version != 0)
+	{
+		m_has_unit_cell = decode<std::int32_t>(icntrl + 4 * 10, m_swap) != 0;
+		m_has_4d = decode<std::int32_t>(icntrl + 4 * 11, m_swap) != 0;
+	}
+	if (fixed_atoms != 0)
+		throw "DCD files with fixed atoms are not supported: " + filename;
+	if (decode<std::int32_t>(header + 88, m_swap) != 84)
+		throw "Corrupt DCD header in " + filename;
+
+	skip_record(); // title
+
+	char natoms[4];
+	read_record(natoms, sizeof(natoms));
+	const auto n_atoms = decode<std::int32_t>(natoms, m_swap);
+	if (n_atoms <= 0)
+		throw "Corrupt DCD header in " + filename;
+	m_natoms = static_cast<size_t>(n_atoms);
+	m_coordinate_buffer.resize(m_natoms);
+}
+
+bool DCDReader::read_frame(float* xyz)
+{
+	std::int32_t marker;
+	if (!read_marker(marker))
+		return false;
+
+	if (m_has_unit_cell)
+	{
+		// six doubles (the unit cell lengths and angles), not needed by the structure
+		if (marker != 48)
+			throw "Corrupt DCD frame in " + m_filename;
+		char cell[52];
+		if (!read_bytes(cell, sizeof(cell)))
+			throw "Truncated frame in " + m_filename;
+		if (!read_marker(marker))
+			throw "Truncated frame in " + m_filename;
+	}
+
+	const size_t record_size = 4 * m_natoms;
+	for (size_t dimension = 0; dimension < 3; ++dimension)
+	{
+		if (dimension > 0 && !read_marker(marker))
+			throw "Truncated frame in " + m_filename;
+		if (static_cast<size_t>(marker) != record_size)
+			throw "Corrupt DCD frame in " + m_filename;
+
+		char* data = reinterpret_cast<char*>(m_coordinate_buffer.data());
+		if (!read_bytes(data, record_size) || !read_marker(marker))
+			throw "Truncated frame in " + m_filename;
+		if (m_swap)
+		{
+			for (size_t atom = 0; atom < m_natoms; ++atom)
+				m_coordinate_buffer[atom] = decode<float>(data + 4 * atom, true);
+		}
+
+		for (size_t atom = 0; atom < m_natoms; ++atom)
+			xyz[3 * atom + dimension] = m_coordinate_buffer[atom];
+	}
+
+	if (m_has_4d)
+		skip_record();
+
+	return true;
+}
+
+bool DCDReader::read_marker(std::int32_t& marker)
+{
+	char data[4];
+	if (!read_bytes(data, sizeof(data)))
+		return false;
+	marker = decode<std::int32_t>(data, m_swap);
+	return true;
+}
+
+void DCDReader::read_record(char* data, size_t size)
+{
+	std::int32_t marker;
+	if (!read_marker(marker) || static_cast<size_t>(marker) != size)
+		throw "Corrupt DCD header in " + m_filename;
+	if (!read_bytes(data, size) || !read_marker(marker))
+		throw "Truncated DCD header in " + m_filename;
+}
+
+void DCDReader::skip_record()
+{
+	std::int32_t marker;
+	if (!read_marker(marker) || marker < 0)
+		throw "Corrupt DCD header in " + m_filename;
+	m_file.seekg(marker, std::ios::cur);
+	if (!read_marker(marker))
+		throw "Truncated DCD header in " + m_filename;
+}
+
+/**
+ * XTC files are XDR (big endian) encoded. Each frame has a header (magic number
+ * 1995, number of atoms, step, time and box) followed by the coordinates, in nm,
+ * which are compressed unless the frame has 9 atoms or less.
+ * The number of atoms is read from the first frame.
+ */
+XTCReader::XTCReader(const std::string& filename)
+	: TrajectoryReader(filename)
+{
+	char header[8];
+	if (!read_bytes(header, sizeof(header)))
+		throw "Empty XTC file: " + filename;
+	const bool swap = is_little_endian();
+	if (decode<std::int32_t>(header, swap) != 1995)
+		throw "Not an XTC file: " + filename;
+	const auto n_atoms = decode<std::int32_t>(header + 4, swap);
+	if (n_atoms <= 0)
+		throw "Corrupt XTC header in " + filename;
+	m_natoms = static_cast<size_t>(n_atoms);
+	m_integer_xyz.resize(3 * m_natoms);
+	m_file.seekg(0);
+}
+
+std::int32_t XTCReader::read_int()
+{
+	char data[4];
+	if (!read_bytes(data, sizeof(data)))
+		throw "Truncated frame in " + m_filename;
+	return decode<std::int32_t>(data, is_little_endian());
+}
+
+float XTCReader::read_float()
+{
+	char data[4];
+	if (!read_bytes(data, sizeof(data)))
+		throw "Truncated frame in " + m_filename;
+	return decode<float>(data, is_little_endian());
+}
+
+bool XTCReader::read_frame(float* xyz)
+{
+	char magic[4];
+	if (!read_bytes(magic, sizeof(magic)))
+		return false;
+	if (decode<std::int32_t>(magic, is_little_endian()) != 1995)
+		throw "Corrupt XTC frame in " + m_filename;
+
+	if (static_cast<size_t>(read_int()) != m_natoms)
+		throw "XTC frames with a different number of atoms in " + m_filename;
+	read_int(); // step
+	read_float(); // time
+	for (int i = 0; i < 9; ++i)
+		read_float(); // box
+
+	if (static_cast<size_t>(read_int()) != m_natoms)
+		throw "Corrupt XTC frame in " + m_filename;
+
+	if (m_natoms <= 9)
+	{
+		for (size_t i = 0; i < 3 * m_natoms; ++i)
+			xyz[i] = read_float();
+	}
+	else
+		decompress(xyz);
+
+	// nm to Angstrom
+	for (size_t i = 0; i < 3 * m_natoms; ++i)
+		xyz[i] *= 10;
+
+	return true;
+}
+
+/**
+ * Port of the decompression of xdr3dfcoord (xdrfile, GROMACS). Coordinates are
+ * integers (the coordinates times the precision) relative to the minimum of the
+ * frame. Most atoms are close to the previous one (e.g. within a residue or a
+ * water molecule), and are stored as runs of small differences, whose size
+ * adapts along the frame. The first atom of a run is swapped with the atom
+ * stored before it, which compresses the hydrogens of water molecules better.
+ */
+void XTCReader::decompress(float* xyz)
+{
+	const float precision = read_float();
+	if (!(precision > 0))
+		throw "Corrupt XTC frame in " + m_filename;
+
+	std::array<std::int32_t, 3> minint, maxint;
+	for (auto& value : minint)
+		value = read_int();
+	for (auto& value : maxint)
+		value = read_int();
+
+	std::array<std::uint32_t, 3> sizeint, bitsizeint {};
+	for (int i = 0; i < 3; ++i)
+		sizeint[i] = static_cast<std::uint32_t>(maxint[i]) - static_cast<std::uint32_t>(minint[i])
+			+ 1;
+
+	// coordinates are stored as three numbers when their range is too large for one
+	int bitsize = 0;
+	if ((sizeint[0] | sizeint[1] | sizeint[2]) > 0xffffff)
+	{
+		for (int i = 0; i < 3; ++i)
+			bitsizeint[i] = static_cast<std::uint32_t>(size_of_int(sizeint[i]));
+	}
+	else
+		bitsize = size_of_ints(sizeint);
+
+	int smallidx = read_int();
+	if (smallidx < first_index || smallidx >= last_index)
+		throw "Corrupt XTC frame in " + m_filename;
+	int smaller = magicints[std::max(first_index, smallidx - 1)] / 2;
+	int smallnum = magicints[smallidx] / 2;
+	std::array<std::uint32_t, 3> sizesmall;
+	sizesmall.fill(static_cast<std::uint32_t>(magicints[smallidx]));
+
+	const auto n_bytes = read_int();
+	if (n_bytes < 0)
+		throw "Corrupt XTC frame in " + m_filename;
+	// XDR opaque data is padded to a multiple of 4 bytes
+	m_compressed.resize((static_cast<size_t>(n_bytes) + 3) & ~size_t { 3 });
+	if (!read_bytes(reinterpret_cast<char*>(m_compressed.data()), m_compressed.size()))
+		throw "Truncated frame in " + m_filename;
+
+	BitReader bits(m_compressed.data(), static_cast<size_t>(n_bytes), m_filename);
+	const float inv_precision = 1.0f / precision;
+	float* output = xyz;
+	std::int32_t* ip = m_integer_xyz.data();
+	std::array<std::int32_t, 3> prevcoord;
+	int run = 0;
+	size_t i = 0;
+	while (i < m_natoms)
+	{
+		std::int32_t* thiscoord = ip + 3 * i;
+		if (bitsize == 0)
+		{
+			for (int k = 0; k < 3; ++k)
+				thiscoord[k] = static_cast<std::int32_t>(bits.read(bitsizeint[k]));
+		}
+		else
+			bits.read_ints(bitsize, sizeint, thiscoord);
+
+		++i;
+		for (int k = 0; k < 3; ++k)
+		{
+			thiscoord[k] += minint[k];
+			prevcoord[k] = thiscoord[k];
+		}
+
+		// the run length (a multiple of 3) and the change of smallidx are only
+		// stored when they change
+		int is_smaller = 0;
+		if (bits.read(1) == 1)
+		{
+			run = static_cast<int>(bits.read(5));
+			is_smaller = run % 3;
+			run -= is_smaller;
+			--is_smaller;
+		}
+
+		if (run > 0)
+		{
+			if (i + run / 3 > m_natoms)
+				throw "Corrupt XTC frame in " + m_filename;
+			thiscoord += 3;
+			for (int k = 0; k < run; k += 3)
+			{
+				bits.read_ints(smallidx, sizesmall, thiscoord);
+				++i;
+				for (int d = 0; d < 3; ++d)
+					thiscoord[d] += prevcoord[d] - smallnum;
+				if (k == 0)
+				{
+					// the first atom of the run was stored before the previous atom
+					for (int d = 0; d < 3; ++d)
+						std::swap(thiscoord[d], prevcoord[d]);
+					for (int d = 0; d < 3; ++d)
+						*output++ = prevcoord[d] * inv_precision;
+				}
+				else
+				{
+					for (int d = 0; d < 3; ++d)
+						prevcoord[d] = thiscoord[d];
+				}
+				for (int d = 0; d < 3; ++d)
+					*output++ = thiscoord[d] * inv_precision;
+			}
+		}
+		else
+		{
+			for (int d = 0; d < 3; ++d)
+				*output++ = thiscoord[d] * inv_precision;
+		}
+
+		smallidx += is_smaller;
+		if (smallidx < first_index || smallidx >= last_index)
+			throw "Corrupt XTC frame in " + m_filename;
+		if (is_smaller < 0)
+		{
+			smallnum = smaller;
+			smaller = smallidx > first_index ? magicints[smallidx - 1] / 2 : 0;
+		}
+		else if (is_smaller > 0)
+		{
+			smaller = smallnum;
+			smallnum = magicints[smallidx] / 2;
+		}
+		sizesmall.fill(static_cast<std::uint32_t>(magicints[smallidx]));
+	}
+}
+
+std::unique_ptr<TrajectoryReader> prostruct::parsers::open_trajectory(const std::string& filename)
+{
+	const auto dot = filename.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : filename.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+	if (extension == "dcd")
+		return std::make_unique<DCDReader>(filename);
+	if (extension == "xtc")
+		return std::make_unique<XTCReader>(filename);
+	throw "Unknown trajectory file format: " + filename;
+}
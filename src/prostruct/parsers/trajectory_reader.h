@@ -0,0 +1,105 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_TRAJECTORY_READER_H
+#define PROSTRUCT_TRAJECTORY_READER_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace prostruct::parsers
+{
+	/**
+	 * A trajectory file that is read one frame at a time, so that memory use
+	 * does not depend on the number of frames. Frames are in single precision
+	 * (as stored by DCD and XTC files), in Angstrom and in the atom order of
+	 * the file.
+	 */
+	class TrajectoryReader
+	{
+	public:
+		virtual ~TrajectoryReader() = default;
+
+		size_t n_atoms() const noexcept { return m_natoms; }
+
+		/**
+		 * Reads the next frame into xyz, which has room for 3 * n_atoms values
+		 * (x, y and z of each atom in turn). Returns false at the end of the file.
+		 */
+		virtual bool read_frame(float* xyz) = 0;
+
+	protected:
+		explicit TrajectoryReader(const std::string& filename);
+
+		/**
+		 * Reads size bytes. Returns false if the file ends before the first byte
+		 * and throws if it ends after it.
+		 */
+		bool read_bytes(char* data, size_t size);
+
+		std::string m_filename;
+		std::ifstream m_file;
+		size_t m_natoms = 0;
+	};
+
+	/**
+	 * CHARMM/NAMD/LAMMPS DCD files, in either byte order. Files with fixed atoms
+	 * are not supported.
+	 */
+	class DCDReader : public TrajectoryReader
+	{
+	public:
+		explicit DCDReader(const std::string& filename);
+
+		bool read_frame(float* xyz) override;
+
+	private:
+		/** Reads a Fortran record marker (a 4 byte record length) */
+		bool read_marker(std::int32_t& marker);
+
+		/** Reads a record of exactly size bytes into data */
+		void read_record(char* data, size_t size);
+
+		void skip_record();
+
+		bool m_swap = false;
+		bool m_has_unit_cell = false;
+		bool m_has_4d = false;
+		std::vector<float> m_coordinate_buffer;
+	};
+
+	/**
+	 * GROMACS XTC files, including the decompression of the coordinates
+	 * compressed by xdrfile (xdr3dfcoord).
+	 */
+	class XTCReader : public TrajectoryReader
+	{
+	public:
+		explicit XTCReader(const std::string& filename);
+
+		bool read_frame(float* xyz) override;
+
+	private:
+		std::int32_t read_int();
+		float read_float();
+
+		/** Decodes the compressed coordinates of the current frame, in nm */
+		void decompress(float* xyz);
+
+		std::vector<unsigned char> m_compressed;
+		std::vector<std::int32_t> m_integer_xyz;
+	};
+
+	/** Opens filename as a DCD or XTC file, depending on its extension */
+	std::unique_ptr<TrajectoryReader> open_trajectory(const std::string& filename);
+}
+
+#endif // PROSTRUCT_TRAJECTORY_READER_H
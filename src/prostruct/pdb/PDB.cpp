@@ -9,44 +9,316 @@
 #include "PDB.h"
 #include <prostruct/pdb/PDB.h>
 
+#include <limits>
+
 using namespace prostruct;
 
+namespace
+{
+	constexpr std::array<atom_name_t, 4> backbone_names
+		= { pack_atom_name("N"), pack_atom_name("CA"), pack_atom_name("C"), pack_atom_name("O") };
+
+	/**
+	 * Writes the atoms of a residue to table starting at first_atom, with
+	 * the backbone atoms first (N, CA, C, O) followed by the sidechain in file order.
+	 * The position in the table of each atom is stored in table_positions at the
+	 * index of the atom in the file.
+	 */
+	template <typename T>
+	void write_residue(AtomTable<T>& table, const parsers::ParsedStructure<T>& structure,
+		const parsers::ResidueRange& residue, arma::uword first_atom, arma::uword residue_index,
+		std::vector<arma::uword>& table_positions)
+	{
+		arma::uword n_backbone = 0;
+		arma::uword sidechain_position = first_atom + 4;
+
+		for (size_t i = residue.first_atom; i < residue.first_atom + residue.n_atoms; ++i)
+		{
+			const auto& record = structure.atoms[i];
+			const auto name = pack_atom_name(record.name);
+			auto backbone_slot = std::find(backbone_names.cbegin(), backbone_names.cend(), name);
+
+			arma::uword position;
+			if (backbone_slot != backbone_names.cend())
+			{
+				position = first_atom + std::distance(backbone_names.cbegin(), backbone_slot);
+				++n_backbone;
+			}
+			else
+				position = sidechain_position++;
+
+			if (position >= first_atom + residue.n_atoms)
+				break;
+
+			table.set_atom(position, element_code(record.element), name, record.x, record.y,
+				record.z, residue_index);
+			table_positions[record.file_index] = position;
+		}
+
+		if (n_backbone != 4)
+			throw "Expected four atoms in the backbone, got " + std::to_string(n_backbone);
+	}
+
+	/**
+	 * Copies the atoms of a structure cache, whose coordinates and radii have
+	 * type U, to table. The radii are returned separately as the Residue
+	 * constructor overwrites the radii of the table.
+	 */
+	template <typename T, typename U>
+	arma::Col<T> read_cached_atoms(AtomTable<T>& table, const parsers::StructureCache& cache)
+	{
+		const U* xyz = cache.xyz<U>();
+		const auto* residues = cache.residues();
+		const auto* names = cache.names();
+		const auto* elements = cache.elements();
+
+		arma::uword next_atom = 0;
+		for (arma::uword i = 0; i < cache.n_residues(); ++i)
+		{
+			// the residues are contiguous and cover the table
+			if (residues[i].first_atom != next_atom
+				|| residues[i].first_atom + residues[i].n_atoms > cache.n_atoms())
+				throw "Corrupt structure cache: invalid residue range";
+			next_atom += residues[i].n_atoms;
+
+			for (arma::uword atom = residues[i].first_atom; atom < next_atom; ++atom)
+				table.set_atom(atom, elements[atom], names[atom], static_cast<T>(xyz[3 * atom]),
+					static_cast<T>(xyz[3 * atom + 1]), static_cast<T>(xyz[3 * atom + 2]), i);
+		}
+		if (next_atom != cache.n_atoms())
+			throw "Corrupt structure cache: invalid residue range";
+
+		arma::Col<T> radii(cache.n_atoms());
+		const U* cached_radii = cache.radii<U>();
+		for (arma::uword atom = 0; atom < cache.n_atoms(); ++atom)
+			radii.at(atom) = static_cast<T>(cached_radii[atom]);
+		return radii;
+	}
+}
+
 template <typename T>
 PDB<T>::PDB(const std::string& filename)
-	: StructBase<T>()
+	: PDB(parsers::parse_pdb<T>(filename), filename)
+{
+}
+
+template <typename T>
+PDB<T>::PDB(const PDB& other)
+	: StructBase<T>(other)
+	, m_table_positions(other.m_table_positions)
+	, m_filename(other.m_filename)
+	, m_chain_order(other.m_chain_order)
+	, m_number_of_chains(other.m_number_of_chains)
+{
+	copy_chains(other);
+}
+
+template <typename T>
+PDB<T>& PDB<T>::operator=(const PDB& other)
+{
+	if (this == &other)
+		return *this;
+	StructBase<T>::operator=(other);
+	m_table_positions = other.m_table_positions;
+	m_filename = other.m_filename;
+	m_chain_order = other.m_chain_order;
+	m_number_of_chains = other.m_number_of_chains;
+	copy_chains(other);
+	return *this;
+}
+
+template <typename T>
+void PDB<T>::copy_chains(const PDB& other)
+{
+	// m_residues holds the residues of each chain in turn
+	m_chain_map.clear();
+	size_t first_residue = 0;
+	for (const auto& name : m_chain_order)
+	{
+		const auto& chain = other.m_chain_map.at(name);
+		const size_t last_residue = first_residue + chain->n_residues();
+		residueVector<T> residues(this->m_residues.begin() + first_residue,
+			this->m_residues.begin() + last_residue);
+		m_chain_map[name] = std::make_shared<Chain<T>>(
+			residues, name, this->m_atom_table, chain->first_atom(), chain->n_atoms());
+		first_residue = last_residue;
+	}
+}
+
+/**
+ * All the atoms are stored in a single AtomTable owned by the PDB, and the chains
+ * and residues are views into it, so that transformations of the PDB coordinates
+ * are seen by every chain and residue.
+ * The PDB is built in two passes: the first computes where each residue and chain
+ * starts in the table, the second writes the atoms to their final position, so that
+ * the table is allocated once and construction is linear in the number of atoms.
+ */
+template <typename T>
+PDB<T>::PDB(parsers::ParsedStructure<T>&& structure, const std::string& filename)
+	: StructBase<T>(std::make_shared<AtomTable<T>>(structure.atoms.size()), 0,
+		structure.atoms.size())
+	, m_table_positions(structure.atoms.size(), std::numeric_limits<arma::uword>::max())
 	, m_filename(filename)
+	, m_chain_order(std::move(structure.chain_order))
 {
-	std::map<std::string, std::map<std::string, atomVector<T>, AASequenceOrder>> chainAtomMap;
+	const auto& ranges = structure.residues;
 
-	createMap(m_filename, chainAtomMap, m_chain_order);
+	// first pass: offsets of each residue in the table and of each chain in ranges
+	std::vector<arma::uword> residue_first_atom(ranges.size() + 1, 0);
+	std::vector<size_t> chain_first_residue(m_chain_order.size() + 1, ranges.size());
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		residue_first_atom[i + 1] = residue_first_atom[i] + ranges[i].n_atoms;
+		if (i == 0 || ranges[i].chain_index != ranges[i - 1].chain_index)
+			chain_first_residue[ranges[i].chain_index] = i;
+	}
 
-	this->m_natoms = 0;
-	this->m_nresidues = 0;
-	this->m_xyz.set_size(3, 0);
-	arma::uword start_current_atom = 0;
-	arma::uword end_current_atom = 0;
-	for (const auto& chain : m_chain_order)
+	// second pass: write the atoms and create the residues and chains
+	this->m_residues.reserve(ranges.size());
+	for (std::uint32_t chain_index = 0; chain_index < m_chain_order.size(); ++chain_index)
 	{
+		const size_t first_residue = chain_first_residue[chain_index];
+		const size_t last_residue = chain_first_residue[chain_index + 1];
 		residueVector<T> residues;
-		const std::map<std::string, atomVector<T>, AASequenceOrder> chain_i
-			= chainAtomMap.at(chain);
-		this->append_new_residue(*chain_i.cbegin(), residues, true, false);
-		for (auto atomPair = std::next(chain_i.cbegin()); atomPair != std::prev(chain_i.cend());
-			 ++atomPair)
+		residues.reserve(last_residue - first_residue);
+
+		for (size_t i = first_residue; i < last_residue; ++i)
 		{
-			this->append_new_residue(*atomPair, residues, false, false);
+			const auto& first_record = structure.atoms[ranges[i].first_atom];
+
+			write_residue(*this->m_atom_table, structure, ranges[i], residue_first_atom[i], i,
+				m_table_positions);
+
+			// residue ID, e.g. ALA-1-A
+			std::string residue_id(first_record.residue_name);
+			residue_id.push_back('-');
+			residue_id.append(first_record.residue_sequence);
+			residue_id.push_back('-');
+			residue_id.append(first_record.insertion_code);
+
+			residues.emplace_back(std::make_shared<Residue<T>>(this->m_atom_table,
+				residue_first_atom[i], ranges[i].n_atoms, std::string(first_record.residue_name),
+				residue_id, i == first_residue, i + 1 == last_residue));
 		}
-		this->append_new_residue(*std::prev(chain_i.cend()), residues, false, true);
-		end_current_atom += this->m_natoms - start_current_atom;
-		m_chain_map[chain] = std::make_shared<Chain<T>>(residues, chain,
-			this->m_xyz(arma::span::all, arma::span(start_current_atom, end_current_atom - 1)));
-		start_current_atom = end_current_atom;
-		this->m_nresidues += static_cast<arma::uword>(residues.size());
+
+		m_chain_map[m_chain_order[chain_index]] = std::make_shared<Chain<T>>(residues,
+			m_chain_order[chain_index], this->m_atom_table, residue_first_atom[first_residue],
+			residue_first_atom[last_residue] - residue_first_atom[first_residue]);
 		this->m_residues.insert(this->m_residues.end(), residues.begin(), residues.end());
 	}
+	this->m_nresidues = static_cast<arma::uword>(ranges.size());
 	this->m_number_of_chains = static_cast<int>(m_chain_map.size());
 }
 
+/**
+ * The residues and chains are rebuilt from their ranges of atoms in the cache,
+ * and the atoms are copied once from the memory mapped file to the AtomTable.
+ */
+template <typename T>
+PDB<T>::PDB(const parsers::StructureCache& cache)
+	: StructBase<T>(std::make_shared<AtomTable<T>>(cache.n_atoms()), 0, cache.n_atoms())
+	, m_table_positions(cache.table_positions(), cache.table_positions() + cache.n_atoms())
+	, m_filename(cache.string(cache.header().source))
+{
+	const arma::Col<T> radii = cache.header().scalar_size == sizeof(float)
+		? read_cached_atoms<T, float>(*this->m_atom_table, cache)
+		: read_cached_atoms<T, double>(*this->m_atom_table, cache);
+
+	const auto* cached_residues = cache.residues();
+	const auto* cached_chains = cache.chains();
+	auto residue_first_atom = [&](arma::uword i) -> arma::uword {
+		return i < cache.n_residues() ? cached_residues[i].first_atom : cache.n_atoms();
+	};
+
+	this->m_residues.reserve(cache.n_residues());
+	m_chain_order.reserve(cache.n_chains());
+	for (arma::uword chain_index = 0; chain_index < cache.n_chains(); ++chain_index)
+	{
+		const arma::uword first_residue = cached_chains[chain_index].first_residue;
+		const arma::uword last_residue = first_residue + cached_chains[chain_index].n_residues;
+		if (first_residue != this->m_residues.size() || last_residue > cache.n_residues())
+			throw "Corrupt structure cache: invalid chain range";
+
+		residueVector<T> residues;
+		residues.reserve(last_residue - first_residue);
+		for (arma::uword i = first_residue; i < last_residue; ++i)
+		{
+			const auto& residue = cached_residues[i];
+			residues.emplace_back(std::make_shared<Residue<T>>(this->m_atom_table,
+				residue.first_atom, residue.n_atoms,
+				std::string(cache.string(residue.amino_acid_name)),
+				std::string(cache.string(residue.residue_name)), i == first_residue,
+				i + 1 == last_residue));
+		}
+
+		m_chain_order.emplace_back(cache.string(cached_chains[chain_index].name));
+		m_chain_map[m_chain_order.back()] = std::make_shared<Chain<T>>(residues,
+			m_chain_order.back(), this->m_atom_table, residue_first_atom(first_residue),
+			residue_first_atom(last_residue) - residue_first_atom(first_residue));
+		this->m_residues.insert(this->m_residues.end(), residues.begin(), residues.end());
+	}
+	if (this->m_residues.size() != cache.n_residues())
+		throw "Corrupt structure cache: invalid chain range";
+
+	// the saved radii, in case they were changed after the structure was parsed
+	this->m_atom_table->radii() = radii;
+	this->m_nresidues = static_cast<arma::uword>(cache.n_residues());
+	this->m_number_of_chains = static_cast<int>(m_chain_map.size());
+}
+
+template <typename T>
+void PDB<T>::save(const std::string& filename) const
+{
+	const AtomTable<T>& table = *this->m_atom_table;
+
+	parsers::StructureCacheSections sections;
+	sections.scalar_size = sizeof(T);
+	sections.xyz = table.xyz().memptr();
+	sections.radii = table.radii().memptr();
+	sections.names = table.names().data();
+	sections.elements = table.elements().data();
+	sections.table_positions.assign(m_table_positions.cbegin(), m_table_positions.cend());
+	sections.source = sections.strings.add(m_filename);
+
+	sections.residues.reserve(this->m_residues.size());
+	sections.chains.reserve(m_chain_order.size());
+	for (std::uint32_t chain_index = 0; chain_index < m_chain_order.size(); ++chain_index)
+	{
+		const auto& chain = m_chain_map.at(m_chain_order[chain_index]);
+		const std::uint64_t first_residue = sections.residues.size();
+		const std::uint64_t n_residues = chain->n_residues();
+
+		// m_residues holds the residues of each chain in turn
+		for (std::uint64_t i = first_residue; i < first_residue + n_residues; ++i)
+		{
+			const auto& residue = this->m_residues[i];
+			parsers::CachedResidue cached {};
+			cached.first_atom = residue->first_atom();
+			cached.n_atoms = static_cast<std::uint32_t>(residue->n_atoms());
+			cached.chain_index = chain_index;
+			cached.amino_acid_name = sections.strings.add(residue->get_amino_acid_name());
+			cached.residue_name = sections.strings.add(residue->get_name());
+			cached.amino_acid = static_cast<std::uint32_t>(residue->get_amino_acid_type());
+			sections.residues.push_back(cached);
+		}
+
+		parsers::CachedChain cached {};
+		cached.first_residue = first_residue;
+		cached.n_residues = n_residues;
+		cached.name = sections.strings.add(m_chain_order[chain_index]);
+		sections.chains.push_back(cached);
+	}
+
+	parsers::write_structure_cache(filename, table.n_atoms(), sections);
+}
+
+template <typename T>
+std::shared_ptr<PDB<T>> PDB<T>::load(const std::string& filename)
+{
+	const parsers::StructureCache cache(filename);
+	return std::shared_ptr<PDB<T>>(new PDB<T>(cache));
+}
+
 template <typename T>
 PDB<T> PDB<T>::fetch(std::string PDB_id)
 {
@@ -10,6 +10,7 @@
 #define PROSTRUCT_PDB_H
 
 #include <prostruct/parsers/PDBparser.h>
+#include <prostruct/parsers/structure_cache.h>
 #include <prostruct/pdb/struct_base.h>
 #include <prostruct/struct/chain.h>
 #include <prostruct/utils/io.h>
@@ -25,6 +26,8 @@ namespace prostruct
 	class StructBase;
 	template <typename T>
 	class Chain;
+	template <typename T>
+	class PDBLoader;
 
 	template <typename T>
 	class PDB : public StructBase<T>
@@ -32,8 +35,28 @@ namespace prostruct
 	public:
 		PDB(const std::string& filename);
 
+#ifndef SWIG
+		/** A copy with its own AtomTable, chains and residues, see StructBase */
+		PDB(const PDB& other);
+
+		PDB& operator=(const PDB& other);
+#endif
+
 		static PDB fetch(std::string);
 
+		/**
+		 * Writes the structure to a binary structure cache (see
+		 * parsers::StructureCacheHeader), which load reads back much faster than
+		 * the PDB file can be parsed.
+		 */
+		void save(const std::string& filename) const;
+
+		/**
+		 * Loads a structure written by save, with PDB<float> or PDB<double>.
+		 * Throws if the file is not a valid structure cache.
+		 */
+		static std::shared_ptr<PDB<T>> load(const std::string& filename);
+
 		virtual std::string to_string() const
 		{
 			return format(fmt("<prostruct.PDB {} precision, with {} atoms, {} "
@@ -50,6 +73,25 @@ namespace prostruct
 
 		std::vector<std::string> get_chain_names() const noexcept { return m_chain_order; }
 
+		/**
+		 * Solvent accessible surface area of each chain (in the order of
+		 * get_chain_names), computed in the context of the whole structure.
+		 */
+		arma::Col<T> compute_chain_sasa(T probe = 1.4, int n_sphere_points = 960) const noexcept
+		{
+			const arma::Col<T> asa = this->compute_shrake_rupley(probe, n_sphere_points);
+			arma::Col<T> result(m_chain_order.size());
+
+			for (arma::uword i = 0; i < m_chain_order.size(); ++i)
+			{
+				const auto& chain = m_chain_map.at(m_chain_order[i]);
+				const arma::uword first_atom = chain->first_atom() - this->m_first_atom;
+				result.at(i) = arma::accu(
+					asa.subvec(first_atom, first_atom + chain->n_atoms() - 1));
+			}
+			return result;
+		}
+
 #ifndef SWIG
 		template <typename... Args>
 		arma::Col<arma::uword> get_atom_indices(Args... patterns) const noexcept
@@ -60,12 +102,12 @@ namespace prostruct
 
 			for (const auto& chain_name : m_chain_order)
 			{
-				arma::Col<arma::uword> residue_atoms
-					= m_chain_map[chain_name]->get_atom_indices(std::forward<Args>(patterns)...);
+				const auto& chain = m_chain_map.at(chain_name);
+				arma::Col<arma::uword> residue_atoms = chain->get_atom_indices(patterns...);
 				max_result(arma::span(i, i + residue_atoms.n_rows - 1))
 					= residue_atoms + position_in_pdb;
 				i += residue_atoms.n_rows;
-				position_in_pdb += m_chain_map[chain_name]->m_natoms;
+				position_in_pdb += chain->n_atoms();
 			}
 
 			arma::Col<arma::uword> result = max_result.head(i);
@@ -75,9 +117,73 @@ namespace prostruct
 #endif
 		// virtual arma::Mat<T> get_backbone_atoms() const noexcept override;
 
+		/**
+		 * Superposed RMSD of every pair of structures, which must have the same
+		 * number of atoms, e.g. from a list of PDBs in Python.
+		 */
+		static arma::Mat<T> kabsch_rmsd_matrix(
+			const std::vector<std::shared_ptr<PDB<T>>>& structures)
+		{
+			return StructBase<T>::kabsch_rmsd_matrix(structures);
+		}
+
+		/** The upper triangle of kabsch_rmsd_matrix, row by row */
+		static arma::Col<T> condensed_kabsch_rmsd_matrix(
+			const std::vector<std::shared_ptr<PDB<T>>>& structures)
+		{
+			return StructBase<T>::condensed_kabsch_rmsd_matrix(structures);
+		}
+
 		int n_chains() { return m_number_of_chains; }
 
+#ifndef SWIG
+		/**
+		 * The position in the AtomTable (and in get_xyz) of each atom, in the
+		 * order of the file, e.g. to read the frames of a trajectory.
+		 */
+		const std::vector<arma::uword>& get_table_positions() const noexcept
+		{
+			return m_table_positions;
+		}
+
+		/**
+		 * Copies the coordinates of every atom, given in the order of the file
+		 * (x, y and z of each atom in turn), to their position in the structure,
+		 * e.g. to load a frame of a trajectory.
+		 */
+		template <typename U>
+		void set_file_order_xyz(const U* xyz) noexcept
+		{
+			for (size_t atom = 0; atom < m_table_positions.size(); ++atom)
+			{
+				const arma::uword position = m_table_positions[atom];
+				if (position >= this->m_xyz.n_cols)
+					continue;
+				T* target = this->m_xyz.colptr(position);
+				target[0] = static_cast<T>(xyz[3 * atom]);
+				target[1] = static_cast<T>(xyz[3 * atom + 1]);
+				target[2] = static_cast<T>(xyz[3 * atom + 2]);
+			}
+		}
+#endif
+
+	protected:
+#ifndef SWIG
+		/** Builds the PDB from the first model of structure */
+		PDB(parsers::ParsedStructure<T>&& structure, const std::string& filename);
+
+		/** Builds the PDB from a structure cache, see load */
+		explicit PDB(const parsers::StructureCache& cache);
+
+		friend class PDBLoader<T>;
+#endif
+
+		std::vector<arma::uword> m_table_positions;
+
 	private:
+		/** Builds the chains of this copy of other from its residues */
+		void copy_chains(const PDB& other);
+
 		std::string m_filename;
 		std::vector<std::string> m_chain_order;
 		std::map<std::string, std::shared_ptr<Chain<T>>> m_chain_map;
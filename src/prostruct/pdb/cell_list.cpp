@@ -0,0 +1,173 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/pdb/cell_list.h>
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace prostruct::geometry
+{
+	template <typename T>
+	CellList<T>::CellList(const arma::Mat<T>& xyz, T cell_size)
+		: m_cell_size(cell_size)
+		, m_origin({ 0, 0, 0 })
+		, m_dims({ 1, 1, 1 })
+	{
+		if (!(cell_size > 0))
+			throw "Cell size must be positive";
+
+		const arma::uword n_points = xyz.n_cols;
+		std::array<T, 3> upper = { 0, 0, 0 };
+
+		if (n_points > 0)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				m_origin[axis] = xyz.at(axis, 0);
+				upper[axis] = xyz.at(axis, 0);
+			}
+			for (arma::uword i = 1; i < n_points; ++i)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					m_origin[axis] = std::min(m_origin[axis], xyz.at(axis, i));
+					upper[axis] = std::max(upper[axis], xyz.at(axis, i));
+				}
+			}
+		}
+
+		// sparse point clouds would need far more cells than points, in which case
+		// the cells are made larger, which is still correct as they only need to be
+		// at least cell_size wide
+		const double max_cells = 8.0 * static_cast<double>(n_points) + 27.0;
+		while (true)
+		{
+			double n_cells = 1.0;
+			for (int axis = 0; axis < 3; ++axis)
+				n_cells *= std::floor((upper[axis] - m_origin[axis]) / m_cell_size) + 1.0;
+			if (n_cells <= max_cells)
+				break;
+			m_cell_size *= static_cast<T>(std::max(std::cbrt(n_cells / max_cells), 1.1));
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+			m_dims[axis]
+				= static_cast<arma::sword>((upper[axis] - m_origin[axis]) / m_cell_size) + 1;
+
+		// counting sort of the points by cell
+		std::vector<arma::uword> point_cell(n_points);
+		m_cell_start.assign(this->n_cells() + 1, 0);
+
+		for (arma::uword i = 0; i < n_points; ++i)
+		{
+			const auto cell = cell_of(xyz.at(0, i), xyz.at(1, i), xyz.at(2, i));
+			point_cell[i] = static_cast<arma::uword>(
+				(cell[0] * m_dims[1] + cell[1]) * m_dims[2] + cell[2]);
+			++m_cell_start[point_cell[i] + 1];
+		}
+
+		std::partial_sum(m_cell_start.begin(), m_cell_start.end(), m_cell_start.begin());
+
+		m_points.resize(n_points);
+		std::vector<arma::uword> position(m_cell_start.begin(), m_cell_start.end() - 1);
+		for (arma::uword i = 0; i < n_points; ++i)
+			m_points[position[point_cell[i]]++] = i;
+	}
+
+	namespace
+	{
+		/**
+		 * Builds the list of pairs of distinct points for which is_neighbour(i, j, distance^2)
+		 * holds, where the neighbours of each point must be closer than cell_size.
+		 * Each point is visited twice, once to count its neighbours and once to
+		 * store them, so that the list is written without reallocations.
+		 */
+		template <typename T, typename F>
+		NeighbourList build_neighbour_list(const arma::Mat<T>& xyz, T cell_size, F&& is_neighbour)
+		{
+			const arma::uword n_points = xyz.n_cols;
+			NeighbourList result;
+			result.offsets.assign(n_points + 1, 0);
+
+			if (n_points == 0)
+				return result;
+
+			const CellList<T> cells(xyz, cell_size);
+
+			auto visit_neighbours = [&](arma::uword i, auto&& f) {
+				const T x = xyz.at(0, i);
+				const T y = xyz.at(1, i);
+				const T z = xyz.at(2, i);
+				cells.for_each_candidate(x, y, z, [&](arma::uword j) {
+					if (i == j)
+						return;
+					const T dx = xyz.at(0, j) - x;
+					const T dy = xyz.at(1, j) - y;
+					const T dz = xyz.at(2, j) - z;
+					if (is_neighbour(i, j, dx * dx + dy * dy + dz * dz))
+						f(j);
+				});
+			};
+
+#pragma omp parallel for schedule(dynamic, 256)
+			for (arma::uword i = 0; i < n_points; ++i)
+			{
+				arma::uword count = 0;
+				visit_neighbours(i, [&count](arma::uword) { ++count; });
+				result.offsets[i + 1] = count;
+			}
+
+			std::partial_sum(result.offsets.begin(), result.offsets.end(), result.offsets.begin());
+			result.indices.resize(result.offsets.back());
+
+#pragma omp parallel for schedule(dynamic, 256)
+			for (arma::uword i = 0; i < n_points; ++i)
+			{
+				arma::uword* neighbours = result.indices.data() + result.offsets[i];
+				arma::uword count = 0;
+				visit_neighbours(i, [&](arma::uword j) { neighbours[count++] = j; });
+				std::sort(neighbours, neighbours + count);
+			}
+
+			return result;
+		}
+	}
+
+	template <typename T>
+	NeighbourList neighbour_list(const arma::Mat<T>& xyz, const arma::Col<T>& radii, T padding)
+	{
+		const T max_radius = radii.n_elem > 0 ? radii.max() : T { 0 };
+		const T cell_size = std::max(2 * max_radius + padding, std::numeric_limits<T>::min());
+
+		return build_neighbour_list(
+			xyz, cell_size, [&radii, padding](arma::uword i, arma::uword j, T distance_2) {
+				const T cutoff = radii.at(i) + radii.at(j) + padding;
+				return distance_2 < cutoff * cutoff;
+			});
+	}
+
+	template <typename T>
+	NeighbourList neighbour_list(const arma::Mat<T>& xyz, T cutoff)
+	{
+		const T cutoff_2 = cutoff * cutoff;
+		return build_neighbour_list(xyz, std::max(cutoff, std::numeric_limits<T>::min()),
+			[cutoff_2](arma::uword, arma::uword, T distance_2) { return distance_2 < cutoff_2; });
+	}
+
+	template class CellList<float>;
+	template class CellList<double>;
+
+	template NeighbourList neighbour_list(const arma::Mat<float>&, const arma::Col<float>&, float);
+	template NeighbourList neighbour_list(
+		const arma::Mat<double>&, const arma::Col<double>&, double);
+
+	template NeighbourList neighbour_list(const arma::Mat<float>&, float);
+	template NeighbourList neighbour_list(const arma::Mat<double>&, double);
+}
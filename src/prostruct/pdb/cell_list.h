@@ -0,0 +1,131 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_CELL_LIST_H
+#define PROSTRUCT_CELL_LIST_H
+
+#include <armadillo>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace prostruct::geometry
+{
+	/**
+	 * Neighbour list in compressed sparse row format: the neighbours of point i
+	 * are indices[offsets[i]], ..., indices[offsets[i + 1] - 1], in ascending order.
+	 */
+	struct NeighbourList
+	{
+		std::vector<arma::uword> offsets;
+		std::vector<arma::uword> indices;
+
+		arma::uword n_points() const noexcept
+		{
+			return offsets.empty() ? 0 : static_cast<arma::uword>(offsets.size() - 1);
+		}
+
+		arma::uword n_neighbours(arma::uword i) const noexcept
+		{
+			return offsets[i + 1] - offsets[i];
+		}
+
+		const arma::uword* begin(arma::uword i) const noexcept
+		{
+			return indices.data() + offsets[i];
+		}
+
+		const arma::uword* end(arma::uword i) const noexcept
+		{
+			return indices.data() + offsets[i + 1];
+		}
+	};
+
+	/**
+	 * Uniform grid over a set of points (the columns of a 3 x N matrix), with
+	 * the points of each cell stored contiguously.
+	 * Any two points closer than cell_size are in the same or in adjacent cells,
+	 * so neighbour searches only need to look at 27 cells.
+	 */
+	template <typename T>
+	class CellList
+	{
+	public:
+		CellList(const arma::Mat<T>& xyz, T cell_size);
+
+		/**
+		 * Calls f(j) for every point j in the cell of (x, y, z) and the 26 cells
+		 * around it, i.e. for a superset of the points closer than cell_size.
+		 */
+		template <typename F>
+		void for_each_candidate(T x, T y, T z, F&& f) const
+		{
+			const auto cell = cell_of(x, y, z);
+
+			for (arma::sword ix = std::max<arma::sword>(cell[0] - 1, 0);
+				 ix <= std::min(cell[0] + 1, m_dims[0] - 1); ++ix)
+			{
+				for (arma::sword iy = std::max<arma::sword>(cell[1] - 1, 0);
+					 iy <= std::min(cell[1] + 1, m_dims[1] - 1); ++iy)
+				{
+					const arma::sword first_z = std::max<arma::sword>(cell[2] - 1, 0);
+					const arma::sword last_z = std::min(cell[2] + 1, m_dims[2] - 1);
+					// cells along z are contiguous, so the points of up to three cells
+					// form a single range
+					const auto row = (ix * m_dims[1] + iy) * m_dims[2];
+					for (arma::uword k = m_cell_start[row + first_z];
+						 k < m_cell_start[row + last_z + 1]; ++k)
+						f(m_points[k]);
+				}
+			}
+		}
+
+		T cell_size() const noexcept { return m_cell_size; }
+
+		arma::uword n_cells() const noexcept
+		{
+			return static_cast<arma::uword>(m_dims[0] * m_dims[1] * m_dims[2]);
+		}
+
+	private:
+		std::array<arma::sword, 3> cell_of(T x, T y, T z) const noexcept
+		{
+			const std::array<T, 3> point = { x, y, z };
+			std::array<arma::sword, 3> cell;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				// points outside of the grid are clamped to the closest cell
+				const auto index
+					= static_cast<arma::sword>((point[axis] - m_origin[axis]) / m_cell_size);
+				cell[axis] = std::clamp<arma::sword>(index, 0, m_dims[axis] - 1);
+			}
+			return cell;
+		}
+
+		T m_cell_size;
+		std::array<T, 3> m_origin;
+		std::array<arma::sword, 3> m_dims;
+		std::vector<arma::uword> m_cell_start; /**< offset of each cell in m_points */
+		std::vector<arma::uword> m_points; /**< point indices sorted by cell */
+	};
+
+	/**
+	 * Pairs of distinct points i, j with distance(i, j) < radii(i) + radii(j) + padding.
+	 */
+	template <typename T>
+	NeighbourList neighbour_list(const arma::Mat<T>& xyz, const arma::Col<T>& radii, T padding = 0);
+
+	/**
+	 * Pairs of distinct points i, j with distance(i, j) < cutoff.
+	 */
+	template <typename T>
+	NeighbourList neighbour_list(const arma::Mat<T>& xyz, T cutoff);
+}
+
+#endif // PROSTRUCT_CELL_LIST_H
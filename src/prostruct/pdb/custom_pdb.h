@@ -10,6 +10,8 @@
 #include <prostruct/pdb/PDB.h>
 #include <prostruct/utils/io.h>
 
+#include <algorithm>
+
 #ifndef PROSTRUCT_CustomPDB_H
 #define PROSTRUCT_CustomPDB_H
 
@@ -17,10 +19,11 @@
 
 namespace prostruct
 {
-	class CustomPDB : public PDB<float>
+	template <typename T>
+	class CustomPDB : public PDB<T>
 	{
 	public:
-		CustomPDB(const std::string& filename): PDB<float>(filename) {};
+		CustomPDB(const std::string& filename): PDB<T>(filename) {};
 
 		virtual ~CustomPDB() {}
 
@@ -29,33 +32,145 @@ namespace prostruct
 			// repeated here due to swig director (bug?)
 			return format(fmt("<prostruct.PDB {} precision, with {} atoms, {} "
 							  "residues at {}>"),
-				demangled_type<float>(), m_natoms, m_nresidues, fmt::ptr(this));
+				demangled_type<T>(), this->m_natoms, this->m_nresidues, fmt::ptr(this));
 		}
 
-		virtual float custom_kernel(const std::shared_ptr<Residue<float>>& residue,
-			const std::shared_ptr<Residue<float>>& next_residue) const
+		virtual T custom_kernel(const std::shared_ptr<Residue<T>>& residue,
+			const std::shared_ptr<Residue<T>>& next_residue) const
 		{
 			throw "Error, custom kernel has not been defined";
 		}
 
-		arma::Col<float> run_custom_kernel() const
+		/**
+		 * The batched version of custom_kernel, which is called once with the
+		 * atoms of all residues so that it can be vectorised (e.g. with NumPy):
+		 * - backbone: the N, CA, C and O of each residue (n_residues x 4 x 3 in NumPy)
+		 * - sidechain: the sidechain atoms of all residues (n_sidechain_atoms x 3)
+		 * - sidechain_offsets: the sidechain of residue i is
+		 *   sidechain[sidechain_offsets[i]:sidechain_offsets[i + 1]]
+		 * - amino_acids: the AminoAcid of each residue
+		 * - chain_starts: 1 for the first residue of each chain, 0 otherwise
+		 * It returns one value per residue.
+		 */
+		virtual arma::Col<T> custom_batch_kernel(arma::Cube<T> backbone, arma::Mat<T> sidechain,
+			arma::Col<arma::uword> sidechain_offsets, arma::Col<arma::uword> amino_acids,
+			arma::Col<arma::uword> chain_starts) const
+		{
+			throw "Error, custom batch kernel has not been defined";
+		}
+
+		/**
+		 * The pairwise version of custom_batch_kernel, which takes the same
+		 * arguments and returns a n_residues x n_residues matrix.
+		 */
+		virtual arma::Mat<T> custom_pairwise_batch_kernel(arma::Cube<T> backbone,
+			arma::Mat<T> sidechain, arma::Col<arma::uword> sidechain_offsets,
+			arma::Col<arma::uword> amino_acids, arma::Col<arma::uword> chain_starts) const
+		{
+			throw "Error, custom pairwise batch kernel has not been defined";
+		}
+
+		arma::Col<T> run_custom_kernel() const
 		{
-			auto custom_lambda = [this](const std::shared_ptr<Residue<float>>& residue,
-									 const std::shared_ptr<Residue<float>>& next_residue) -> float {
+			auto custom_lambda = [this](const std::shared_ptr<Residue<T>>& residue,
+									 const std::shared_ptr<Residue<T>>& next_residue) -> T {
 				return this->custom_kernel(residue, next_residue);
 			};
-			return arma::Col<float>(
+			return arma::Col<T>(
 				core::residue_kernel_engine(this->m_residues, 0, custom_lambda).memptr(),
-				m_nresidues);
+				this->m_nresidues);
 		}
 
-		arma::Mat<float> run_custom_pairwise_kernel() const
+		arma::Mat<T> run_custom_pairwise_kernel() const
 		{
-			auto custom_lambda = [this](const std::shared_ptr<Residue<float>>& residue,
-									 const std::shared_ptr<Residue<float>>& next_residue) -> float {
+			auto custom_lambda = [this](const std::shared_ptr<Residue<T>>& residue,
+									 const std::shared_ptr<Residue<T>>& next_residue) -> T {
 				return this->custom_kernel(residue, next_residue);
 			};
-			return core::pairwise_residue_kernel_engine(this->m_residues, 0, custom_lambda).slice(0);
+			return core::pairwise_residue_kernel_engine(this->m_residues, 0, custom_lambda)
+				.slice(0);
+		}
+
+		/**
+		 * Runs custom_batch_kernel. Unlike run_custom_kernel, which calls into
+		 * Python (and takes the GIL) for every residue, this gathers the atoms
+		 * in C++ without the GIL, and calls into Python once.
+		 */
+		arma::Col<T> run_custom_batch_kernel() const
+		{
+			Batch batch = gather_batch();
+			auto result = custom_batch_kernel(std::move(batch.backbone),
+				std::move(batch.sidechain), std::move(batch.sidechain_offsets),
+				std::move(batch.amino_acids), std::move(batch.chain_starts));
+			if (result.n_elem != static_cast<arma::uword>(this->m_nresidues))
+				throw "Expected the custom batch kernel to return a value per residue";
+			return result;
+		}
+
+		/** Runs custom_pairwise_batch_kernel, see run_custom_batch_kernel */
+		arma::Mat<T> run_custom_pairwise_batch_kernel() const
+		{
+			Batch batch = gather_batch();
+			auto result = custom_pairwise_batch_kernel(std::move(batch.backbone),
+				std::move(batch.sidechain), std::move(batch.sidechain_offsets),
+				std::move(batch.amino_acids), std::move(batch.chain_starts));
+			const auto n_residues = static_cast<arma::uword>(this->m_nresidues);
+			if (result.n_rows != n_residues || result.n_cols != n_residues)
+				throw "Expected the custom pairwise batch kernel to return a value per pair";
+			return result;
+		}
+
+	private:
+		struct Batch
+		{
+			arma::Cube<T> backbone;
+			arma::Mat<T> sidechain;
+			arma::Col<arma::uword> sidechain_offsets;
+			arma::Col<arma::uword> amino_acids;
+			arma::Col<arma::uword> chain_starts;
+		};
+
+		/** The arguments of the batch kernels */
+		Batch gather_batch() const
+		{
+			const auto& residues = this->m_residues;
+			const arma::uword n_residues = residues.size();
+			Batch batch;
+
+			batch.sidechain_offsets.set_size(n_residues + 1);
+			batch.sidechain_offsets[0] = 0;
+			for (arma::uword i = 0; i < n_residues; ++i)
+			{
+				// as in Residue::get_sidechain_atoms
+				const arma::uword n_sidechain_atoms
+					= residues[i]->get_amino_acid_type() == AminoAcid::GLY
+					? 0
+					: residues[i]->n_atoms() - 4;
+				batch.sidechain_offsets[i + 1] = batch.sidechain_offsets[i] + n_sidechain_atoms;
+			}
+
+			batch.backbone.set_size(3, 4, n_residues);
+			batch.sidechain.set_size(3, batch.sidechain_offsets[n_residues]);
+			batch.amino_acids.set_size(n_residues);
+			batch.chain_starts.set_size(n_residues);
+			const auto chain_starts = this->chain_starts();
+
+#pragma omp parallel for
+			for (arma::uword i = 0; i < n_residues; ++i)
+			{
+				const arma::Mat<T>& xyz = residues[i]->xyz_ref();
+				std::copy(xyz.colptr(0), xyz.colptr(0) + 12, batch.backbone.slice_memptr(i));
+
+				const arma::uword first = batch.sidechain_offsets[i];
+				const arma::uword n_sidechain_atoms = batch.sidechain_offsets[i + 1] - first;
+				std::copy(xyz.colptr(4), xyz.colptr(4) + 3 * n_sidechain_atoms,
+					batch.sidechain.colptr(first));
+
+				batch.amino_acids[i] = static_cast<arma::uword>(residues[i]->get_amino_acid_type());
+				batch.chain_starts[i] = chain_starts[i] ? 1 : 0;
+			}
+
+			return batch;
 		}
 	};
 }
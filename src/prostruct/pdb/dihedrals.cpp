@@ -6,6 +6,7 @@
  *
  */
 
+#include "prostruct/core/kernels.h"
 #include "prostruct/pdb/geometry.h"
 
 namespace prostruct
@@ -24,6 +25,86 @@ namespace prostruct
 			return std::atan2(arma::dot(arma::cross(n1, b2), n2), arma::dot(n1, n2)) * coef;
 		}
 
+		/**
+		 * Each residue is independent, so the torsions are vectorised across
+		 * residues in two passes; the backbone atoms of residue i are the 12 values
+		 * starting at atoms + first_atom(i). The first pass computes the y and x of
+		 * each torsion, and the second their angle with kernels::vector_atan2, as
+		 * a loop that calls std::atan2 is not vectorised (without -ffast-math).
+		 */
+		template <typename T, typename FirstAtom>
+		void torsions(const T* atoms, FirstAtom&& first_atom, arma::uword n_residues,
+			const std::vector<bool>& chain_start, bool use_radians, arma::Mat<T>& result)
+		{
+			if (result.n_rows != 3 || result.n_cols != n_residues)
+				result.set_size(3, n_residues);
+
+			const T coef = use_radians ? 1 : kernels::to_rad_constant<T>;
+			const arma::uword n_peptide_bonds = n_residues > 0 ? n_residues - 1 : 0;
+			const arma::uword n_torsions = 3 * n_peptide_bonds;
+
+			// the y of each torsion is kept in result until the second pass, and the
+			// x in a buffer per thread that is only reallocated when it grows
+			thread_local std::vector<T> x_terms;
+			if (x_terms.size() < n_torsions)
+				x_terms.resize(n_torsions);
+			T* y = result.memptr();
+			T* x = x_terms.data();
+
+#pragma omp simd
+			for (arma::uword i = 0; i < n_peptide_bonds; ++i)
+			{
+				const T* N = atoms + first_atom(i);
+				const T* CA = N + 3;
+				const T* C = N + 6;
+				const T* N_next = atoms + first_atom(i + 1);
+				const T* CA_next = N_next + 3;
+				const T* C_next = N_next + 6;
+				kernels::dihedral_terms(C, N_next, CA_next, C_next, y[3 * i], x[3 * i]);
+				kernels::dihedral_terms(N, CA, C, N_next, y[3 * i + 1], x[3 * i + 1]);
+				kernels::dihedral_terms(CA, C, N_next, CA_next, y[3 * i + 2], x[3 * i + 2]);
+			}
+
+#pragma omp simd
+			for (arma::uword i = 0; i < n_torsions; ++i)
+				y[i] = kernels::vector_atan2(y[i], x[i]) * coef;
+
+			// there is no peptide bond after the last residue of each chain
+			for (arma::uword i = 0; i < n_residues; ++i)
+			{
+				if (i == n_peptide_bonds || (i + 1 < chain_start.size() && chain_start[i + 1]))
+					result.col(i).zeros();
+			}
+		}
+
+		template <typename T>
+		void backbone_torsions(const arma::Mat<T>& xyz, const std::vector<bool>& chain_start,
+			bool use_radians, arma::Mat<T>& result)
+		{
+			torsions(
+				xyz.memptr(), [](arma::uword i) { return 12 * i; }, xyz.n_cols / 4, chain_start,
+				use_radians, result);
+		}
+
+		template <typename T>
+		void backbone_torsions(const arma::Mat<T>& xyz, const std::vector<arma::uword>& first_atoms,
+			const std::vector<bool>& chain_start, bool use_radians, arma::Mat<T>& result)
+		{
+			const arma::uword* first = first_atoms.data();
+			torsions(
+				xyz.memptr(), [first](arma::uword i) { return 3 * first[i]; }, first_atoms.size(),
+				chain_start, use_radians, result);
+		}
+
+		template void backbone_torsions(
+			const arma::Mat<float>&, const std::vector<bool>&, bool, arma::Mat<float>&);
+		template void backbone_torsions(
+			const arma::Mat<double>&, const std::vector<bool>&, bool, arma::Mat<double>&);
+		template void backbone_torsions(const arma::Mat<float>&, const std::vector<arma::uword>&,
+			const std::vector<bool>&, bool, arma::Mat<float>&);
+		template void backbone_torsions(const arma::Mat<double>&, const std::vector<arma::uword>&,
+			const std::vector<bool>&, bool, arma::Mat<double>&);
+
 		template float dihedrals(const arma::Col<float>&, const arma::Col<float>&,
 			const arma::Col<float>&, const arma::Col<float>&, float);
 		template double dihedrals(const arma::Col<double>&, const arma::Col<double>&,
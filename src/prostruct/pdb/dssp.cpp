@@ -26,8 +26,14 @@
 // the N-H group.
 //
 
+#include "prostruct/pdb/cell_list.h"
 #include "prostruct/pdb/geometry.h"
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <tuple>
+
 namespace prostruct
 {
 	namespace geometry
@@ -58,11 +64,55 @@ namespace prostruct
 			}
 		}
 
+		namespace
+		{
+			template <typename T>
+			T inverse_distance(const T* a, const T* b) noexcept
+			{
+				const T dx = a[0] - b[0];
+				const T dy = a[1] - b[1];
+				const T dz = a[2] - b[2];
+				return 1 / std::sqrt(dx * dx + dy * dy + dz * dz);
+			}
+
+			/**
+			 * E = 0.084 { 1 / rON + 1 / rCH − 1 / rOH − 1 / rCN } ⋅ 332 kcal/mol
+			 * between the C=O of acceptor and the N-H of donor, where xyz has
+			 * the N, CA, C and O coordinates of each residue.
+			 */
+			template <typename T>
+			T hbond_energy(const arma::Mat<T>& xyz, const arma::Mat<T>& H_coords,
+				arma::uword acceptor, arma::uword donor) noexcept
+			{
+				constexpr T E_coefficient = 27.888;
+				const T* N = xyz.colptr(donor * 4);
+				const T* H = H_coords.colptr(donor);
+				const T* C = xyz.colptr(acceptor * 4 + 2);
+				const T* O = xyz.colptr(acceptor * 4 + 3);
+
+				return (inverse_distance(N, O) + inverse_distance(H, C) - inverse_distance(H, O)
+						   - inverse_distance(N, C))
+					* E_coefficient;
+			}
+
+			/** Keeps bonds sorted by energy, with the two lowest energies */
+			template <typename T>
+			void insert_bond(std::array<HBond<T>, 2>& bonds, arma::uword partner, T energy) noexcept
+			{
+				if (energy < bonds[0].energy)
+				{
+					bonds[1] = bonds[0];
+					bonds[0] = { partner, energy };
+				}
+				else if (energy < bonds[1].energy)
+					bonds[1] = { partner, energy };
+			}
+		}
+
 		template <typename T>
 		void kabsch_sander(const arma::Mat<T>& xyz, arma::Mat<T>& E)
 		{
 			constexpr T ca_dist_squared = 81.0;
-			constexpr T E_coefficient = 27.888;
 			arma::Mat<T> H_coords(3, E.n_cols, arma::fill::zeros);
 			predict_H_coords(xyz, H_coords);
 #pragma omp parallel for collapse(2)
@@ -79,83 +129,528 @@ namespace prostruct
 							< ca_dist_squared)
 						{
 							// N, CA, C, O
-							// E = 0.084 { 1 / rON + 1 / rCH − 1 / rOH − 1 / rCN } ⋅ 332 kcal/mol
-							// where r is the distance between A and B sqrt(dot(A-B, A-B)
-							// and we do this for each possible combination -> gives a matrix
+							// we do this for each possible combination -> gives a matrix
 							// residue x residue
-							T rev_rON = 1
-								/ std::sqrt(arma::dot(xyz(arma::span::all, donor * 4)
-										- xyz(arma::span::all, acceptor * 4 + 3),
-									xyz(arma::span::all, donor * 4)
-										- xyz(arma::span::all, acceptor * 4 + 3)));
-							T rev_rCH = 1
-								/ std::sqrt(arma::dot(
-									H_coords.col(donor) - xyz(arma::span::all, acceptor * 4 + 2),
-									H_coords.col(donor) - xyz(arma::span::all, acceptor * 4 + 2)));
-							T rev_rOH = 1
-								/ std::sqrt(arma::dot(
-									H_coords.col(donor) - xyz(arma::span::all, acceptor * 4 + 3),
-									H_coords.col(donor) - xyz(arma::span::all, acceptor * 4 + 3)));
-							T rev_rCN = 1
-								/ std::sqrt(arma::dot(xyz(arma::span::all, donor * 4)
-										- xyz(arma::span::all, acceptor * 4 + 2),
-									xyz(arma::span::all, donor * 4)
-										- xyz(arma::span::all, acceptor * 4 + 2)));
-							E.at(acceptor, donor)
-								= (rev_rON + rev_rCH - rev_rOH - rev_rCN) * E_coefficient;
+							E.at(acceptor, donor) = hbond_energy(xyz, H_coords, acceptor, donor);
 						}
 					}
 				}
 			}
 		}
 
-		static void predict_alpha_helix()
+		template <typename T>
+		HBondList<T> kabsch_sander_sparse(
+			const arma::Mat<T>& xyz, const std::vector<bool>& can_donate)
 		{
+			const arma::uword n_residues = xyz.n_cols / 4;
+			HBondList<T> result(n_residues);
 
-			// Based on this, eight types of secondary structure are assigned. The 310 helix, α
-			// helix and π helix have symbols G,
-			// H and I and are recognized by having a repetitive sequence of hydrogen bonds in which
-			// the residues are three, four, or five residues apart respectively. Two types of beta
-			// sheet structures exist; a beta bridge has symbol B while longer sets of hydrogen
-			// bonds and beta bulges have symbol E. T is used for turns, featuring hydrogen bonds
-			// typical of helices, S is used for regions of high curvature (where the angle between
-			// Ciα C(i+2)α and C(i−2)α Ciα is at least 70°), and a blank (or space) is used if no
-			// other rule applies, referring to loops.[2] These eight types are usually grouped into
-			// three larger classes: helix (G, H and I), strand (E and B) and loop (S, T, and C,
-			// where C sometimes is represented also as blank space).
-		}
+			if (n_residues == 0)
+				return result;
 
-		// template <typename T>
-		void predict_beta_sheet() {}
+			arma::Mat<T> H_coords(3, n_residues, arma::fill::zeros);
+			predict_H_coords(xyz, H_coords);
 
-		template <typename T>
-		void dssp(const arma::Mat<T>& C_coords, const arma::Mat<T>& O_coords,
-			const arma::Mat<T>& N_coords, const arma::Mat<T>& CA_coords)
+			arma::Mat<T> CA_coords(3, n_residues);
+			for (arma::uword i = 0; i < n_residues; ++i)
+				CA_coords.col(i) = xyz.col(i * 4 + 1);
+
+			// only residues with CA atoms closer than 9 A are considered
+			const auto neighbours = neighbour_list(CA_coords, T { 9.0 });
+
+			// the first residue has no predicted H
+			auto donates = [&can_donate](arma::uword residue) {
+				return can_donate.empty() ? residue > 0 : static_cast<bool>(can_donate[residue]);
+			};
+
+			// every residue fills in its own bonds, as donor and as acceptor, so that
+			// the loop can run in parallel
+#pragma omp parallel for schedule(dynamic, 64)
+			for (arma::uword residue = 0; residue < n_residues; ++residue)
+			{
+				for (auto partner = neighbours.begin(residue); partner != neighbours.end(residue);
+					 ++partner)
+				{
+					if (*partner + 1 == residue || residue + 1 == *partner)
+						continue;
+
+					if (donates(residue))
+						insert_bond(result.donor_bonds[residue], *partner,
+							hbond_energy(xyz, H_coords, *partner, residue));
+
+					if (donates(*partner))
+						insert_bond(result.acceptor_bonds[residue], *partner,
+							hbond_energy(xyz, H_coords, residue, *partner));
+				}
+			}
+
+			return result;
+		}
+
+		namespace
 		{
+			enum class HelixFlag
+			{
+				None,
+				Start,
+				End,
+				StartAndEnd,
+				Middle
+			};
+
+			enum class BridgeType
+			{
+				None,
+				Parallel,
+				AntiParallel
+			};
+
+			struct Bridge
+			{
+				BridgeType type;
+				std::deque<arma::uword> i;
+				std::deque<arma::uword> j;
+			};
+
+			constexpr char ss_code(SS_Types type) noexcept
+			{
+				switch (type)
+				{
+				case Helix_310:
+					return 'G';
+				case Helix_alpha:
+					return 'H';
+				case Helix_pi:
+					return 'I';
+				case Bridge_beta:
+					return 'B';
+				case Bridge_beta_buldge:
+					return 'E';
+				case Loop_turn:
+					return 'T';
+				case Loop_high_curvature:
+					return 'S';
+				default:
+					return ' ';
+				}
+			}
+
+			/**
+			 * The state shared by the steps of the assignment, which follow the
+			 * DSSP program (Kabsch and Sander, 1983, and its reference
+			 * implementation).
+			 */
+			template <typename T>
+			class DSSP
+			{
+			public:
+				DSSP(const arma::Mat<T>& xyz, const HBondList<T>& hbonds,
+					const std::vector<bool>& chain_start)
+					: m_xyz(xyz)
+					, m_hbonds(hbonds)
+					, m_n_residues(xyz.n_cols / 4)
+					, m_breaks(m_n_residues + 1, 0)
+					, m_helix_flags(m_n_residues)
+					, m_ss(m_n_residues, Blank)
+					, m_sheets(m_n_residues, ' ')
+				{
+					// m_breaks[i] is the number of chain breaks before residue i: a new
+					// chain or a peptide bond longer than 2.5 A
+					for (arma::uword i = 1; i < m_n_residues; ++i)
+					{
+						const bool is_break = (i < chain_start.size() && chain_start[i])
+							|| arma::norm(m_xyz.col(i * 4) - m_xyz.col((i - 1) * 4 + 2)) > 2.5;
+						m_breaks[i] = m_breaks[i - 1] + is_break;
+					}
+				}
+
+				void assign(std::string& codes, std::string& sheets)
+				{
+					assign_beta_sheets();
+					assign_helices();
+					assign_turns_and_bends();
+
+					codes.assign(m_n_residues, ' ');
+					std::transform(m_ss.cbegin(), m_ss.cend(), codes.begin(), ss_code);
+					sheets = m_sheets;
+				}
+
+			private:
+				bool no_chain_break(arma::uword i, arma::uword j) const noexcept
+				{
+					return m_breaks[i] == m_breaks[j];
+				}
+
+				/** Whether the N-H of donor is bonded to the C=O of acceptor */
+				bool test_bond(arma::uword donor, arma::uword acceptor) const noexcept
+				{
+					return m_hbonds.is_bonded(acceptor, donor);
+				}
+
+				BridgeType test_bridge(arma::uword i, arma::uword j) const noexcept
+				{
+					if (i == 0 || j == 0 || i + 1 >= m_n_residues || j + 1 >= m_n_residues)
+						return BridgeType::None;
+
+					const arma::uword a = i - 1, b = i, c = i + 1;
+					const arma::uword d = j - 1, e = j, f = j + 1;
+
+					if (!no_chain_break(a, c) || !no_chain_break(d, f))
+						return BridgeType::None;
+
+					if ((test_bond(c, e) && test_bond(e, a))
+						|| (test_bond(f, b) && test_bond(b, d)))
+						return BridgeType::Parallel;
+					if ((test_bond(c, d) && test_bond(f, a))
+						|| (test_bond(e, b) && test_bond(b, e)))
+						return BridgeType::AntiParallel;
+					return BridgeType::None;
+				}
+
+				/**
+				 * Residues j > i + 2 that can form a bridge with i. A bridge needs a
+				 * hydrogen bond between i - 1, i or i + 1 and j - 1, j or j + 1, so the
+				 * candidates are the residues next to the bond partners of i and its
+				 * neighbours, which keeps this linear in the number of residues.
+				 */
+				std::vector<arma::uword> bridge_candidates(arma::uword i) const
+				{
+					std::vector<arma::uword> candidates;
+					for (arma::uword k = i - 1; k <= i + 1; ++k)
+					{
+						const auto& donor_bonds = m_hbonds.donor_bonds[k];
+						const auto& acceptor_bonds = m_hbonds.acceptor_bonds[k];
+						for (const auto* bonds : { &donor_bonds, &acceptor_bonds })
+						{
+							for (const auto& bond : *bonds)
+							{
+								if (bond.partner == no_partner)
+									continue;
+								for (arma::uword j = bond.partner > 0 ? bond.partner - 1 : 0;
+									 j <= bond.partner + 1; ++j)
+								{
+									if (j >= i + 3 && j + 1 < m_n_residues)
+										candidates.push_back(j);
+								}
+							}
+						}
+					}
+					std::sort(candidates.begin(), candidates.end());
+					candidates.erase(
+						std::unique(candidates.begin(), candidates.end()), candidates.end());
+					return candidates;
+				}
+
+				void assign_beta_sheets()
+				{
+					std::vector<Bridge> bridges;
+					// the bridge (if any) that the pair (type, i, j) would extend
+					std::map<std::tuple<BridgeType, arma::uword, arma::uword>, size_t> open_bridges;
+
+					for (arma::uword i = 1; i + 4 < m_n_residues; ++i)
+					{
+						for (const auto j : bridge_candidates(i))
+						{
+							const auto type = test_bridge(i, j);
+							if (type == BridgeType::None)
+								continue;
+
+							auto extended = open_bridges.find({ type, i, j });
+							size_t index;
+							if (extended != open_bridges.end())
+							{
+								index = extended->second;
+								open_bridges.erase(extended);
+								bridges[index].i.push_back(i);
+								if (type == BridgeType::Parallel)
+									bridges[index].j.push_back(j);
+								else
+									bridges[index].j.push_front(j);
+							}
+							else
+							{
+								index = bridges.size();
+								bridges.push_back({ type, { i }, { j } });
+							}
+
+							// parallel bridges continue with (i + 1, j + 1),
+							// antiparallel ones with (i + 1, j - 1)
+							if (type == BridgeType::Parallel)
+								open_bridges[{ type, i + 1, bridges[index].j.back() + 1 }] = index;
+							else if (bridges[index].j.front() > 0)
+								open_bridges[{ type, i + 1, bridges[index].j.front() - 1 }] = index;
+						}
+					}
 
-			arma::uword n_residues = C_coords.n_cols;
-			std::vector<bool> has_Hbond(n_residues, false);
+					merge_ladders(bridges);
+					const auto sheets = group_sheets(bridges);
 
-			// All the code is in column major -> each cartesian point is stored in a column (rather
-			// than a row)
-			arma::Mat<T> E(n_residues, n_residues);
+					for (size_t ladder = 0; ladder < bridges.size(); ++ladder)
+					{
+						const auto& bridge = bridges[ladder];
+						const SS_Types type
+							= bridge.i.size() > 1 ? Bridge_beta_buldge : Bridge_beta;
+						// sheets are labelled A to Z, as in the SHEET column of DSSP
+						const char sheet = static_cast<char>('A' + (sheets[ladder] - 1) % 26);
+						for (const auto& range : { &bridge.i, &bridge.j })
+						{
+							for (arma::uword k = range->front(); k <= range->back(); ++k)
+							{
+								if (m_ss[k] != Bridge_beta_buldge)
+									m_ss[k] = type;
+								m_sheets[k] = sheet;
+							}
+						}
+					}
+				}
+
+				/** Whether the ladders a and b have a residue in common */
+				static bool linked(const Bridge& a, const Bridge& b)
+				{
+					for (const auto* first : { &a.i, &a.j })
+					{
+						for (const auto* second : { &b.i, &b.j })
+						{
+							if (std::find_first_of(first->begin(), first->end(), second->begin(),
+									second->end())
+								!= first->end())
+								return true;
+						}
+					}
+					return false;
+				}
+
+				/**
+				 * The sheet (from 1) of each ladder: the sheets are the sets of
+				 * linked ladders, numbered in the order of their first ladder.
+				 */
+				static std::vector<arma::uword> group_sheets(const std::vector<Bridge>& bridges)
+				{
+					std::vector<arma::uword> sheets(bridges.size(), 0);
+					arma::uword n_sheets = 0;
+					for (size_t first = 0; first < bridges.size(); ++first)
+					{
+						if (sheets[first] != 0)
+							continue;
+
+						sheets[first] = ++n_sheets;
+						std::vector<size_t> stack = { first };
+						while (!stack.empty())
+						{
+							const size_t ladder = stack.back();
+							stack.pop_back();
+							for (size_t other = first + 1; other < bridges.size(); ++other)
+							{
+								if (sheets[other] == 0 && linked(bridges[ladder], bridges[other]))
+								{
+									sheets[other] = n_sheets;
+									stack.push_back(other);
+								}
+							}
+						}
+					}
+					return sheets;
+				}
 
-			// kabsch_sander(C_coords, O_coords, N_coords, CA_coords, E, n_residues);
+				/** from <= to and to - from < limit, as the unsigned gaps of DSSP */
+				static bool within(arma::uword from, arma::uword to, arma::uword limit) noexcept
+				{
+					return to >= from && to - from < limit;
+				}
+
+				/** Joins ladders that are only separated by a beta bulge */
+				void merge_ladders(std::vector<Bridge>& bridges) const
+				{
+					std::stable_sort(bridges.begin(), bridges.end(),
+						[](const Bridge& a, const Bridge& b) { return a.i.front() < b.i.front(); });
+
+					for (size_t first = 0; first < bridges.size(); ++first)
+					{
+						auto& bridge_i = bridges[first];
+						for (size_t second = first + 1; second < bridges.size(); ++second)
+						{
+							auto& bridge_j = bridges[second];
+							const arma::uword ibi = bridge_i.i.front(), iei = bridge_i.i.back();
+							const arma::uword jbi = bridge_j.i.front(), jei = bridge_j.i.back();
+							const arma::uword ibj = bridge_i.j.front(), iej = bridge_i.j.back();
+							const arma::uword jbj = bridge_j.j.front(), jej = bridge_j.j.back();
+
+							// the bridges are sorted by their first residue
+							if (jbi >= iei + 6)
+								break;
+
+							if (bridge_i.type != bridge_j.type
+								|| !no_chain_break(std::min(ibi, jbi), std::max(iei, jei))
+								|| !no_chain_break(std::min(ibj, jbj), std::max(iej, jej))
+								|| !within(iei, jbi, 6) || (iei >= jbi && ibi <= jei))
+								continue;
+
+							bool bulge;
+							if (bridge_i.type == BridgeType::Parallel)
+								bulge = (within(iej, jbj, 6) && within(iei, jbi, 3))
+									|| within(iej, jbj, 3);
+							else
+								bulge = (within(jej, ibj, 6) && within(iei, jbi, 3))
+									|| within(jej, ibj, 3);
 
-			std::vector<SS_Types> secondaryStructure(n_residues);
+							if (!bulge)
+								continue;
 
-			predict_alpha_helix();
+							bridge_i.i.insert(
+								bridge_i.i.end(), bridge_j.i.begin(), bridge_j.i.end());
+							if (bridge_i.type == BridgeType::Parallel)
+								bridge_i.j.insert(
+									bridge_i.j.end(), bridge_j.j.begin(), bridge_j.j.end());
+							else
+								bridge_i.j.insert(
+									bridge_i.j.begin(), bridge_j.j.begin(), bridge_j.j.end());
 
-			predict_beta_sheet();
+							bridges.erase(bridges.begin() + second);
+							--second;
+						}
+					}
+				}
+
+				bool is_helix_start(arma::uword i, int stride) const noexcept
+				{
+					const auto flag = m_helix_flags[i][stride - 3];
+					return flag == HelixFlag::Start || flag == HelixFlag::StartAndEnd;
+				}
+
+				/**
+				 * Sets the minimal helices G, H and I of residues, i.e. two
+				 * consecutive n-turns (hydrogen bonds from i + n to i) with n = 3, 4 or 5.
+				 */
+				void assign_helices()
+				{
+					for (int stride = 3; stride <= 5; ++stride)
+					{
+						for (arma::uword i = 0; i + stride < m_n_residues; ++i)
+						{
+							if (!no_chain_break(i, i + stride) || !test_bond(i + stride, i))
+								continue;
+
+							auto& flags = m_helix_flags;
+							flags[i + stride][stride - 3] = HelixFlag::End;
+							for (arma::uword j = i + 1; j < i + stride; ++j)
+							{
+								if (flags[j][stride - 3] == HelixFlag::None)
+									flags[j][stride - 3] = HelixFlag::Middle;
+							}
+							flags[i][stride - 3] = flags[i][stride - 3] == HelixFlag::End
+								? HelixFlag::StartAndEnd
+								: HelixFlag::Start;
+						}
+					}
+
+					for (arma::uword i = 1; i + 4 < m_n_residues; ++i)
+					{
+						if (is_helix_start(i, 4) && is_helix_start(i - 1, 4))
+							std::fill(m_ss.begin() + i, m_ss.begin() + i + 4, Helix_alpha);
+					}
+
+					assign_helix_if_empty(3, Helix_310);
+					assign_helix_if_empty(5, Helix_pi);
+				}
+
+				void assign_helix_if_empty(int stride, SS_Types type)
+				{
+					for (arma::uword i = 1; i + stride < m_n_residues; ++i)
+					{
+						if (!is_helix_start(i, stride) || !is_helix_start(i - 1, stride))
+							continue;
+
+						const auto first = m_ss.begin() + i;
+						const auto last = first + stride;
+						if (std::all_of(first, last,
+								[type](SS_Types ss) { return ss == Blank || ss == type; }))
+							std::fill(first, last, type);
+					}
+				}
+
+				void assign_turns_and_bends()
+				{
+					for (arma::uword i = 1; i + 1 < m_n_residues; ++i)
+					{
+						if (m_ss[i] != Blank)
+							continue;
+
+						bool is_turn = false;
+						for (int stride = 3; stride <= 5 && !is_turn; ++stride)
+						{
+							for (int k = 1; k < stride && !is_turn; ++k)
+								is_turn = i >= static_cast<arma::uword>(k)
+									&& is_helix_start(i - k, stride);
+						}
+
+						if (is_turn)
+							m_ss[i] = Loop_turn;
+						else if (is_bend(i))
+							m_ss[i] = Loop_high_curvature;
+					}
+				}
+
+				/** The angle between CA(i - 2) -> CA(i) and CA(i) -> CA(i + 2) is over 70° */
+				bool is_bend(arma::uword i) const noexcept
+				{
+					if (i < 2 || i + 2 >= m_n_residues || !no_chain_break(i - 2, i + 2))
+						return false;
+
+					const arma::Col<T> before
+						= m_xyz.col(i * 4 + 1) - m_xyz.col((i - 2) * 4 + 1);
+					const arma::Col<T> after
+						= m_xyz.col((i + 2) * 4 + 1) - m_xyz.col(i * 4 + 1);
+					const T cos_kappa
+						= arma::dot(before, after) / (arma::norm(before) * arma::norm(after));
+
+					return cos_kappa < std::cos(70.0 * M_PI / 180.0);
+				}
+
+				const arma::Mat<T>& m_xyz;
+				const HBondList<T>& m_hbonds;
+				arma::uword m_n_residues;
+				std::vector<arma::uword> m_breaks;
+				std::vector<std::array<HelixFlag, 3>> m_helix_flags;
+				std::vector<SS_Types> m_ss;
+				std::string m_sheets;
+			};
+		}
+
+		template <typename T>
+		void dssp(const arma::Mat<T>& xyz, const HBondList<T>& hbonds,
+			const std::vector<bool>& chain_start, std::string& codes, std::string& sheets)
+		{
+			if (hbonds.n_residues() != xyz.n_cols / 4)
+				throw "Expected one set of hydrogen bonds per residue";
+
+			DSSP<T>(xyz, hbonds, chain_start).assign(codes, sheets);
+		}
+
+		template <typename T>
+		std::string dssp(const arma::Mat<T>& xyz, const HBondList<T>& hbonds,
+			const std::vector<bool>& chain_start)
+		{
+			std::string codes, sheets;
+			dssp(xyz, hbonds, chain_start, codes, sheets);
+			return codes;
 		}
 
 		template void kabsch_sander(const arma::Mat<float>&, arma::Mat<float>&);
 		template void kabsch_sander(const arma::Mat<double>&, arma::Mat<double>&);
 
-		template void dssp(const arma::Mat<float>&, const arma::Mat<float>&,
-			const arma::Mat<float>&, const arma::Mat<float>&);
+		template HBondList<float> kabsch_sander_sparse(
+			const arma::Mat<float>&, const std::vector<bool>&);
+		template HBondList<double> kabsch_sander_sparse(
+			const arma::Mat<double>&, const std::vector<bool>&);
+
+		template std::string dssp(
+			const arma::Mat<float>&, const HBondList<float>&, const std::vector<bool>&);
+		template std::string dssp(
+			const arma::Mat<double>&, const HBondList<double>&, const std::vector<bool>&);
 
-		template void dssp(const arma::Mat<double>&, const arma::Mat<double>&,
-			const arma::Mat<double>&, const arma::Mat<double>&);
+		template void dssp(const arma::Mat<float>&, const HBondList<float>&,
+			const std::vector<bool>&, std::string&, std::string&);
+		template void dssp(const arma::Mat<double>&, const HBondList<double>&,
+			const std::vector<bool>&, std::string&, std::string&);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/pdb/ensemble.h>
+
+using namespace prostruct;
+
+template <typename T>
+Ensemble<T>::Ensemble(const std::string& filename)
+	: Ensemble(parsers::parse_pdb<T>(filename, true), filename)
+{
+}
+
+template <typename T>
+Ensemble<T>::Ensemble(parsers::ParsedStructure<T>&& structure, const std::string& filename)
+	// the arguments are all evaluated before PDB moves from structure, so the
+	// models are taken out of it while it is still intact
+	: Ensemble(std::move(structure), std::move(structure.model_xyz), structure.n_models, filename)
+{
+}
+
+/**
+ * The topology is built by PDB from the first model. The coordinates of the
+ * other models are in file order, and are moved to the position of their atom
+ * in the AtomTable (the backbone atoms of each residue come first).
+ */
+template <typename T>
+Ensemble<T>::Ensemble(parsers::ParsedStructure<T>&& structure, std::vector<T> model_xyz,
+	arma::uword n_models, const std::string& filename)
+	: PDB<T>(std::move(structure), filename)
+	, m_models(3, this->m_natoms, n_models)
+{
+	m_models.slice(0) = this->m_xyz;
+
+	const auto& table_positions = this->m_table_positions;
+	const arma::uword n_atoms = table_positions.size();
+	for (arma::uword model = 1; model < n_models; ++model)
+	{
+		const T* xyz_of_model = model_xyz.data() + 3 * n_atoms * (model - 1);
+		arma::Mat<T>& xyz = m_models.slice(model);
+		for (arma::uword atom = 0; atom < n_atoms; ++atom)
+		{
+			const arma::uword position = table_positions[atom];
+			if (position >= xyz.n_cols)
+				continue;
+			xyz.at(0, position) = xyz_of_model[3 * atom];
+			xyz.at(1, position) = xyz_of_model[3 * atom + 1];
+			xyz.at(2, position) = xyz_of_model[3 * atom + 2];
+		}
+	}
+}
+
+template <typename T>
+void Ensemble<T>::set_model(arma::uword model)
+{
+	check_model(model);
+	this->m_xyz = m_models.slice(model);
+	m_current_model = model;
+}
+
+template <typename T>
+arma::Mat<T> Ensemble<T>::get_model_xyz(arma::uword model) const
+{
+	check_model(model);
+	return m_models.slice(model);
+}
+
+template <typename T>
+Model<T> Ensemble<T>::get_model(arma::uword model)
+{
+	check_model(model);
+	return Model<T>(m_models, model);
+}
+
+template <typename T>
+void Ensemble<T>::check_model(arma::uword model) const
+{
+	if (model >= n_models())
+		throw "Model index out of range: " + std::to_string(model);
+}
+
+template class prostruct::Ensemble<float>;
+template class prostruct::Ensemble<double>;
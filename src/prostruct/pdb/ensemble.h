@@ -0,0 +1,97 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_ENSEMBLE_H
+#define PROSTRUCT_ENSEMBLE_H
+
+#include <prostruct/pdb/PDB.h>
+#include <prostruct/struct/model.h>
+
+namespace prostruct
+{
+	/**
+	 * A multi-model PDB file (e.g. an NMR ensemble), with one topology (chains,
+	 * residues, atom names and radii) built from the first model and the
+	 * coordinates of every model in one 3 x n_atoms x n_models cube.
+	 * The Ensemble is the PDB of its current model: set_model copies the
+	 * coordinates of a model into the structure, so every StructBase analysis
+	 * runs on that model without rebuilding the residues.
+	 */
+	template <typename T>
+	class Ensemble : public PDB<T>
+	{
+	public:
+		Ensemble(const std::string& filename);
+
+		virtual std::string to_string() const
+		{
+			return format(fmt("<prostruct.Ensemble {} precision, with {} models of {} atoms, "
+							  "{} residues at {}>"),
+				demangled_type<T>(), n_models(), this->m_natoms, this->m_nresidues,
+				fmt::ptr(this));
+		}
+
+		arma::uword n_models() const noexcept { return m_models.n_slices; }
+
+		arma::uword current_model() const noexcept { return m_current_model; }
+
+		/**
+		 * Makes model the current model. This overwrites the coordinates of the
+		 * structure (and its chains and residues), so transformations of the
+		 * previous model (e.g. recentre) are not kept.
+		 */
+		void set_model(arma::uword model);
+
+		/** The coordinates of model, as read from the file */
+		arma::Mat<T> get_model_xyz(arma::uword model) const;
+
+		/** Superposed RMSD of every pair of models */
+		arma::Mat<T> compute_rmsd_matrix() const { return geometry::rmsd_matrix(m_models); }
+
+#ifndef SWIG
+		/** A view of the coordinates of model */
+		Model<T> get_model(arma::uword model);
+
+		const arma::Cube<T>& models() const noexcept { return m_models; }
+
+		/**
+		 * Calls f(model_index) with each model in turn as the current model,
+		 * e.g. to compute an analysis of the structure for every model.
+		 */
+		template <typename F>
+		void for_each_model(F&& f)
+		{
+			for (arma::uword model = 0; model < n_models(); ++model)
+			{
+				set_model(model);
+				f(model);
+			}
+		}
+#endif
+
+	private:
+#ifndef SWIG
+		Ensemble(parsers::ParsedStructure<T>&& structure, const std::string& filename);
+
+		/**
+		 * Builds the PDB from the first model of structure, and the other models
+		 * from model_xyz (see parsers::ParsedStructure::model_xyz), which is
+		 * taken out of structure before PDB moves from it.
+		 */
+		Ensemble(parsers::ParsedStructure<T>&& structure, std::vector<T> model_xyz,
+			arma::uword n_models, const std::string& filename);
+#endif
+
+		void check_model(arma::uword model) const;
+
+		arma::Cube<T> m_models;
+		arma::uword m_current_model = 0;
+	};
+}
+
+#endif // PROSTRUCT_ENSEMBLE_H
@@ -9,6 +9,7 @@
 #ifndef PROSTRUCT_GEOMETRY_H
 #define PROSTRUCT_GEOMETRY_H
 
+#include "prostruct/pdb/hbonds.h"
 #include "prostruct/struct/residue.h"
 #include "prostruct/utils/tuple_utils.h"
 #include <armadillo>
@@ -22,13 +23,41 @@ namespace prostruct
 {
 	namespace geometry
 	{
+		/**
+		 * DSSP secondary structure codes (H, B, E, G, I, T, S or a blank for a loop)
+		 * of the residues whose backbone atoms (N, CA, C, O of each residue) are the
+		 * columns of xyz, given their hydrogen bonds. chain_start[i] is true if
+		 * residue i is the first residue of a chain.
+		 */
 		template <typename T>
-		void dssp(
-			const arma::Mat<T>&, const arma::Mat<T>&, const arma::Mat<T>&, const arma::Mat<T>&);
+		std::string dssp(const arma::Mat<T>& xyz, const HBondList<T>& hbonds,
+			const std::vector<bool>& chain_start);
+
+		/**
+		 * As dssp, also giving the sheet of each residue: the residues of the
+		 * ladders (and isolated bridges) that are linked by a common residue have
+		 * the same label, A to Z in order of their first ladder, and the other
+		 * residues a blank.
+		 */
+		template <typename T>
+		void dssp(const arma::Mat<T>& xyz, const HBondList<T>& hbonds,
+			const std::vector<bool>& chain_start, std::string& codes, std::string& sheets);
 
 		template <typename T>
 		void kabsch_sander(const arma::Mat<T>&, arma::Mat<T>&);
 
+		/**
+		 * Kabsch-Sander hydrogen bond energies between the residues whose backbone
+		 * atoms (N, CA, C, O of each residue) are the columns of xyz, keeping the two
+		 * strongest bonds of each residue. Only residues with CA atoms closer than
+		 * 9 A are compared, using a cell list, so this is linear in the number of
+		 * residues. Residues that cannot donate (can_donate[i] is false) have no N-H;
+		 * if can_donate is empty this is only the first residue.
+		 */
+		template <typename T>
+		HBondList<T> kabsch_sander_sparse(
+			const arma::Mat<T>& xyz, const std::vector<bool>& can_donate = {});
+
 		template <typename T>
 		void predict_H_coords(arma::Mat<T>& H_coords, const arma::Mat<T>& C_coords,
 			const arma::Mat<T>& O_coords, const arma::Mat<T>& N_coords);
@@ -37,17 +66,37 @@ namespace prostruct
 		void shrake_rupley(const arma::Mat<T>& xyz, const arma::Col<T>& radii, arma::Col<T>& asa,
 			arma::uword n_atoms, T probe, arma::uword n_sphere_points);
 
-		template <typename T>
-		void get_neighbours(const arma::Mat<T>&, arma::Mat<T>&, int, const arma::Col<T>&);
+		/** Maximum accessible surface area of a residue, used for relative SASA */
+		double max_asa(AminoAcid amino_acid) noexcept;
 
+		/**
+		 * Root mean square deviation of xyz and xyz_other (without superposition),
+		 * sqrt(sum |xyz_i - xyz_other_i|^2 / n_atoms), accumulated in double.
+		 */
 		template <typename T>
 		T rmsd(const arma::Mat<T>& xyz, const arma::Mat<T>& xyz_other);
 
+		/** RMSD of the optimal superposition of xyz onto xyz_other (QCP, no copies) */
 		template <typename T>
-		T kabsch_rmsd_(arma::Mat<T>& xyz, arma::Mat<T>& xyz_other);
+		T kabsch_rmsd_(const arma::Mat<T>& xyz, const arma::Mat<T>& xyz_other);
 
+		/**
+		 * Superposed RMSD of every pair of frames, where each slice of frames is
+		 * the 3 x n_atoms coordinates of one structure (or trajectory frame).
+		 */
 		template <typename T>
-		void kabsch_rotation_(arma::Mat<T>& xyz, arma::Mat<T>& xyz_other);
+		arma::Mat<T> rmsd_matrix(const arma::Cube<T>& frames);
+
+		/**
+		 * The upper triangle of rmsd_matrix, row by row, i.e. the RMSD of frames
+		 * i < j is at n * i - i * (i + 1) / 2 + j - i - 1 (as scipy's pdist).
+		 */
+		template <typename T>
+		arma::Col<T> condensed_rmsd_matrix(const arma::Cube<T>& frames);
+
+		/** Rotates xyz by the rotation that optimally superposes it onto xyz_other */
+		template <typename T>
+		void kabsch_rotation_(arma::Mat<T>& xyz, const arma::Mat<T>& xyz_other);
 		template <typename T>
 		void get_centroid(const arma::Mat<T>& xyz, arma::Col<T>& centroid);
 
@@ -60,6 +109,27 @@ namespace prostruct
 		template <typename T>
 		T dihedrals(const arma::Col<T>& atom1, const arma::Col<T>& atom2, const arma::Col<T>& atom3,
 			const arma::Col<T>& atom4, T coef);
+
+		/**
+		 * The phi, psi and omega torsions (the rows of result) of the residues whose
+		 * backbone atoms (N, CA, C, O of each residue) are the columns of xyz, with
+		 * the columns of calculate_phi_psi: column i has the phi of residue i + 1 and
+		 * the psi and omega of residue i, and is 0 for the last residue of each chain
+		 * (chain_start as in dssp). result is only allocated if it does not have the
+		 * right size, so that this can be called for every frame of a trajectory.
+		 */
+		template <typename T>
+		void backbone_torsions(const arma::Mat<T>& xyz, const std::vector<bool>& chain_start,
+			bool use_radians, arma::Mat<T>& result);
+
+		/**
+		 * As backbone_torsions, with the backbone atoms of residue i in the columns
+		 * first_atoms[i] to first_atoms[i] + 3 of xyz (e.g. all the atoms of a
+		 * structure), so that the backbone does not have to be copied out first.
+		 */
+		template <typename T>
+		void backbone_torsions(const arma::Mat<T>& xyz, const std::vector<arma::uword>& first_atoms,
+			const std::vector<bool>& chain_start, bool use_radians, arma::Mat<T>& result);
 	}
 }
 #endif // PROSTRUCT_GEOMETRY_H
@@ -0,0 +1,69 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_HBONDS_H
+#define PROSTRUCT_HBONDS_H
+
+#include <armadillo>
+
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace prostruct::geometry
+{
+	/** Index used for the partner of a bond that does not exist */
+	constexpr arma::uword no_partner = std::numeric_limits<arma::uword>::max();
+
+	/** A backbone hydrogen bond with a partner residue and its Kabsch-Sander energy */
+	template <typename T>
+	struct HBond
+	{
+		arma::uword partner = no_partner;
+		T energy = 0;
+	};
+
+	/**
+	 * The two strongest (lowest energy) backbone hydrogen bonds of each residue,
+	 * as used by DSSP: those where the N-H of the residue is the donor and those
+	 * where its C=O is the acceptor.
+	 */
+	template <typename T>
+	struct HBondList
+	{
+		explicit HBondList(arma::uword n_residues = 0)
+			: donor_bonds(n_residues)
+			, acceptor_bonds(n_residues)
+		{
+		}
+
+		arma::uword n_residues() const noexcept { return donor_bonds.size(); }
+
+		/**
+		 * Whether the N-H of donor is hydrogen bonded to the C=O of acceptor,
+		 * i.e. one of the two strongest bonds of donor is with acceptor and has an
+		 * energy below threshold (kcal/mol).
+		 */
+		bool is_bonded(arma::uword acceptor, arma::uword donor, T threshold = -0.5) const noexcept
+		{
+			for (const auto& bond : donor_bonds[donor])
+			{
+				if (bond.partner == acceptor && bond.energy < threshold)
+					return true;
+			}
+			return false;
+		}
+
+		/** donor_bonds[i] are bonds of the N-H of residue i, sorted by energy */
+		std::vector<std::array<HBond<T>, 2>> donor_bonds;
+		/** acceptor_bonds[i] are bonds of the C=O of residue i, sorted by energy */
+		std::vector<std::array<HBond<T>, 2>> acceptor_bonds;
+	};
+}
+
+#endif // PROSTRUCT_HBONDS_H
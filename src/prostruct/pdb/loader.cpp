@@ -0,0 +1,234 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/pdb/loader.h>
+
+#include <chrono>
+#include <exception>
+
+using namespace prostruct;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	size_t resolve_n_threads(size_t n_threads)
+	{
+		if (n_threads > 0)
+			return n_threads;
+		return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	/**
+	 * Runs a stage of the loading of a file, adding its duration to stage_ms
+	 * and to total_ns. Returns the error of the stage, empty if there was none.
+	 */
+	template <typename F>
+	std::string run_stage(F&& stage, std::atomic<std::int64_t>& total_ns, double& stage_ms)
+	{
+		const auto start = Clock::now();
+		std::string error;
+		try
+		{
+			stage();
+		}
+		catch (const char* e)
+		{
+			error = e;
+		}
+		catch (const std::string& e)
+		{
+			error = e;
+		}
+		catch (const std::exception& e)
+		{
+			error = e.what();
+		}
+		catch (...)
+		{
+			error = "Unknown error";
+		}
+		const auto elapsed
+			= std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		total_ns += elapsed;
+		stage_ms = elapsed / 1e6;
+		return error;
+	}
+
+	/** Closes the output of a stage once its last thread is done */
+	template <typename Queue>
+	void finish_stage(std::atomic<size_t>& running, Queue& output)
+	{
+		if (--running == 0)
+			output.close();
+	}
+}
+
+template <typename T>
+PDBLoader<T>::PDBLoader(std::vector<std::string> filenames, size_t n_threads, bool keep_order)
+	: m_filenames(std::move(filenames))
+	, m_n_threads(resolve_n_threads(n_threads))
+	, m_keep_order(keep_order)
+	, m_window(8 * m_n_threads)
+	, m_read(m_n_threads)
+	, m_decoded(m_n_threads)
+	, m_assembled(m_n_threads)
+	, m_decoding(m_n_threads)
+	, m_assembling(m_n_threads)
+{
+	m_threads.emplace_back(&PDBLoader::read, this);
+	for (size_t i = 0; i < m_n_threads; ++i)
+	{
+		m_threads.emplace_back(&PDBLoader::decode, this);
+		m_threads.emplace_back(&PDBLoader::assemble, this);
+	}
+}
+
+template <typename T>
+PDBLoader<T>::~PDBLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_window_mutex);
+		m_stopped = true;
+	}
+	m_window_changed.notify_all();
+	m_read.close();
+	m_decoded.close();
+	m_assembled.close();
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+template <typename T>
+std::optional<LoadResult<T>> PDBLoader<T>::next()
+{
+	if (!m_keep_order)
+		return m_assembled.pop();
+
+	while (true)
+	{
+		auto pending = m_pending.find(m_next_index);
+		if (pending != m_pending.end())
+		{
+			std::optional<LoadResult<T>> result(std::move(pending->second));
+			m_pending.erase(pending);
+			{
+				std::lock_guard<std::mutex> lock(m_window_mutex);
+				++m_next_index;
+			}
+			m_window_changed.notify_all();
+			return result;
+		}
+
+		auto result = m_assembled.pop();
+		if (!result)
+			return std::nullopt;
+		const size_t index = result->index;
+		m_pending.emplace(index, std::move(*result));
+	}
+}
+
+template <typename T>
+LoadTimings PDBLoader<T>::timings() const noexcept
+{
+	return { m_read_ns / 1e6, m_decode_ns / 1e6, m_assemble_ns / 1e6 };
+}
+
+template <typename T>
+void PDBLoader<T>::read()
+{
+	for (size_t index = 0; index < m_filenames.size(); ++index)
+	{
+		if (m_keep_order)
+		{
+			// the results that come before a slow file wait for it in m_pending,
+			// so the reader does not get too far ahead of the consumer
+			std::unique_lock<std::mutex> lock(m_window_mutex);
+			m_window_changed.wait(
+				lock, [this, index] { return m_stopped || index < m_next_index + m_window; });
+			if (m_stopped)
+				break;
+		}
+
+		Job job;
+		job.result.index = index;
+		job.result.filename = m_filenames[index];
+		job.result.error = run_stage(
+			[&job]() {
+				job.file.emplace(job.result.filename);
+				job.file->prefetch();
+			},
+			m_read_ns, job.result.timings.read_ms);
+
+		if (!m_read.push(std::move(job)))
+			break;
+	}
+	m_read.close();
+}
+
+template <typename T>
+void PDBLoader<T>::decode()
+{
+	while (auto job = m_read.pop())
+	{
+		if (job->result.error.empty())
+			job->result.error = run_stage(
+				[&job]() { job->structure.emplace(parsers::parse_pdb<T>(std::move(*job->file))); },
+				m_decode_ns, job->result.timings.decode_ms);
+		job->file.reset();
+
+		if (!m_decoded.push(std::move(*job)))
+			break;
+	}
+	finish_stage(m_decoding, m_decoded);
+}
+
+template <typename T>
+void PDBLoader<T>::assemble()
+{
+	while (auto job = m_decoded.pop())
+	{
+		if (job->result.error.empty())
+			job->result.error = run_stage(
+				[&job]() {
+					// the constructor from a parsed structure is not public, so no make_shared
+					job->result.structure.reset(
+						new PDB<T>(std::move(*job->structure), job->result.filename));
+				},
+				m_assemble_ns, job->result.timings.assemble_ms);
+		job->structure.reset();
+
+		if (!m_assembled.push(std::move(job->result)))
+			break;
+	}
+	finish_stage(m_assembling, m_assembled);
+}
+
+template <typename T>
+std::vector<LoadResult<T>> prostruct::load_many(
+	std::vector<std::string> filenames, size_t n_threads, bool keep_order, LoadTimings* timings)
+{
+	PDBLoader<T> loader(std::move(filenames), n_threads, keep_order);
+
+	std::vector<LoadResult<T>> results;
+	results.reserve(loader.n_files());
+	while (auto result = loader.next())
+		results.push_back(std::move(*result));
+
+	if (timings != nullptr)
+		*timings = loader.timings();
+	return results;
+}
+
+template class prostruct::PDBLoader<float>;
+template class prostruct::PDBLoader<double>;
+
+template std::vector<LoadResult<float>> prostruct::load_many<float>(
+	std::vector<std::string>, size_t, bool, LoadTimings*);
+template std::vector<LoadResult<double>> prostruct::load_many<double>(
+	std::vector<std::string>, size_t, bool, LoadTimings*);
@@ -0,0 +1,124 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_LOADER_H
+#define PROSTRUCT_LOADER_H
+
+#include <prostruct/pdb/PDB.h>
+#include <prostruct/utils/bounded_queue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace prostruct
+{
+	/** The time spent by a PDBLoader in each stage of its pipeline */
+	struct LoadTimings
+	{
+		double read_ms = 0; /**< mapping the file and reading it into memory */
+		double decode_ms = 0; /**< decoding and grouping the ATOM records */
+		double assemble_ms = 0; /**< building the PDB */
+	};
+
+	/** A file loaded by a PDBLoader: its structure, or why it could not be loaded */
+	template <typename T>
+	struct LoadResult
+	{
+		size_t index; /**< position of the file in the input */
+		std::string filename;
+		std::shared_ptr<PDB<T>> structure; /**< null if the file could not be loaded */
+		std::string error;
+		LoadTimings timings;
+
+		bool ok() const noexcept { return structure != nullptr; }
+	};
+
+	/**
+	 * Loads many PDB files in a pipeline of three stages that run at the same
+	 * time on different files: a thread maps the files and reads them into
+	 * memory, n_threads threads decode them and n_threads threads build the
+	 * structures. The stages are connected by bounded queues, so at most a few
+	 * files per thread are in memory however many files there are.
+	 * The structures are returned by next() in the order of filenames if
+	 * keep_order, otherwise as soon as they are built. A file that cannot be
+	 * loaded gives a LoadResult with its error and does not stop the others.
+	 */
+	template <typename T>
+	class PDBLoader
+	{
+	public:
+		/** n_threads 0 uses the number of hardware threads */
+		PDBLoader(std::vector<std::string> filenames, size_t n_threads = 0, bool keep_order = true);
+
+		~PDBLoader();
+
+		PDBLoader(const PDBLoader&) = delete;
+		PDBLoader& operator=(const PDBLoader&) = delete;
+
+		/** The next loaded file, or nothing once every file was returned */
+		std::optional<LoadResult<T>> next();
+
+		/** The time spent in each stage so far, summed over all files and threads */
+		LoadTimings timings() const noexcept;
+
+		size_t n_files() const noexcept { return m_filenames.size(); }
+
+	private:
+		struct Job
+		{
+			LoadResult<T> result;
+			std::optional<parsers::MappedFile> file;
+			std::optional<parsers::ParsedStructure<T>> structure;
+		};
+
+		void read();
+		void decode();
+		void assemble();
+
+		std::vector<std::string> m_filenames;
+		size_t m_n_threads;
+		bool m_keep_order;
+		/** how many files the reader can be ahead of the consumer when keep_order */
+		size_t m_window;
+
+		BoundedQueue<Job> m_read;
+		BoundedQueue<Job> m_decoded;
+		BoundedQueue<LoadResult<T>> m_assembled;
+		/** the threads of each stage that are still running */
+		std::atomic<size_t> m_decoding;
+		std::atomic<size_t> m_assembling;
+
+		std::mutex m_window_mutex;
+		std::condition_variable m_window_changed;
+		size_t m_next_index = 0;
+		bool m_stopped = false;
+		/** results that were assembled before the ones before them, when keep_order */
+		std::map<size_t, LoadResult<T>> m_pending;
+
+		std::atomic<std::int64_t> m_read_ns { 0 };
+		std::atomic<std::int64_t> m_decode_ns { 0 };
+		std::atomic<std::int64_t> m_assemble_ns { 0 };
+
+		std::vector<std::thread> m_threads;
+	};
+
+	/**
+	 * Loads every file of filenames with a PDBLoader, see there.
+	 * If timings is given it receives the time spent in each stage.
+	 */
+	template <typename T>
+	std::vector<LoadResult<T>> load_many(std::vector<std::string> filenames,
+		size_t n_threads = 0, bool keep_order = true, LoadTimings* timings = nullptr);
+}
+
+#endif // PROSTRUCT_LOADER_H
@@ -0,0 +1,296 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+// The Quaternion Characteristic Polynomial (QCP) method finds the optimal
+// superposition of two coordinate sets from the largest eigenvalue of a 4 x 4
+// key matrix built from their 3 x 3 inner product matrix. The eigenvalue is the
+// largest root of the characteristic polynomial of the key matrix, found with
+// Newton-Raphson, so neither an SVD nor a rotated copy of the coordinates is
+// needed to get the RMSD. The rotation is the corresponding eigenvector, as a
+// quaternion.
+//
+// D. L. Theobald (2005), Rapid calculation of RMSD using a quaternion-based
+// characteristic polynomial. Acta Crystallographica A 61(4):478-480.
+// P. Liu, D. K. Agrafiotis and D. L. Theobald (2010), Fast determination of the
+// optimal rotational matrix for macromolecular superpositions.
+// J. Comput. Chem. 31(7):1561-1563.
+//
+
+#include "prostruct/pdb/qcp.h"
+
+#include <cmath>
+
+namespace prostruct::geometry
+{
+	namespace
+	{
+		constexpr double eigenvalue_precision = 1e-11;
+		constexpr double eigenvector_precision = 1e-6;
+		constexpr int max_newton_iterations = 50;
+
+		/** The largest eigenvalue of the key matrix of inner_product */
+		double max_eigenvalue(const QCPInnerProduct& inner_product) noexcept
+		{
+			const auto& A = inner_product.A;
+			const double Sxx = A[0], Sxy = A[1], Sxz = A[2];
+			const double Syx = A[3], Syy = A[4], Syz = A[5];
+			const double Szx = A[6], Szy = A[7], Szz = A[8];
+
+			const double Sxx2 = Sxx * Sxx, Syy2 = Syy * Syy, Szz2 = Szz * Szz;
+			const double Sxy2 = Sxy * Sxy, Syz2 = Syz * Syz, Sxz2 = Sxz * Sxz;
+			const double Syx2 = Syx * Syx, Szy2 = Szy * Szy, Szx2 = Szx * Szx;
+
+			const double SyzSzymSyySzz2 = 2.0 * (Syz * Szy - Syy * Szz);
+			const double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+
+			const double C2
+				= -2.0 * (Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
+			const double C1 = 8.0
+				* (Sxx * Syz * Szy + Syy * Szx * Sxz + Szz * Sxy * Syx - Sxx * Syy * Szz
+					- Syz * Szx * Sxy - Szy * Syx * Sxz);
+
+			const double SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+			const double SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+			const double SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+			const double Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+
+			const double C0 = Sxy2Sxz2Syx2Szx2 * Sxy2Sxz2Syx2Szx2
+				+ (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2)
+					* (Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2)
+				+ (-SxzpSzx * SyzmSzy + SxymSyx * (SxxmSyy - Szz))
+					* (-SxzmSzx * SyzpSzy + SxymSyx * (SxxmSyy + Szz))
+				+ (-SxzpSzx * SyzpSzy - SxypSyx * (SxxpSyy - Szz))
+					* (-SxzmSzx * SyzmSzy - SxypSyx * (SxxpSyy + Szz))
+				+ (SxypSyx * SyzpSzy + SxzpSzx * (SxxmSyy + Szz))
+					* (-SxymSyx * SyzmSzy + SxzpSzx * (SxxpSyy + Szz))
+				+ (SxypSyx * SyzmSzy + SxzmSzx * (SxxmSyy - Szz))
+					* (-SxymSyx * SyzpSzy + SxzmSzx * (SxxpSyy - Szz));
+
+			// E0 is an upper bound of the largest eigenvalue, so Newton-Raphson
+			// started there converges to it
+			double eigenvalue = inner_product.E0;
+			for (int i = 0; i < max_newton_iterations; ++i)
+			{
+				const double previous = eigenvalue;
+				const double x2 = eigenvalue * eigenvalue;
+				const double b = (x2 + C2) * eigenvalue;
+				const double a = b + C1;
+				eigenvalue -= (a * eigenvalue + C0) / (2.0 * x2 * eigenvalue + b + a);
+				if (std::abs(eigenvalue - previous) < std::abs(eigenvalue_precision * eigenvalue))
+					break;
+			}
+			return eigenvalue;
+		}
+	}
+
+	template <typename T>
+	QCPInnerProduct qcp_inner_product(const arma::Mat<T>& xyz, const arma::Col<T>& centroid,
+		const arma::Mat<T>& target, const arma::Col<T>& target_centroid)
+	{
+		if (xyz.n_cols != target.n_cols)
+			throw "Atom number mismatch";
+
+		QCPInnerProduct result;
+		result.n_atoms = xyz.n_cols;
+
+		const double cx = centroid.at(0), cy = centroid.at(1), cz = centroid.at(2);
+		const double tx = target_centroid.at(0), ty = target_centroid.at(1),
+					 tz = target_centroid.at(2);
+
+		double A0 = 0, A1 = 0, A2 = 0, A3 = 0, A4 = 0, A5 = 0, A6 = 0, A7 = 0, A8 = 0;
+		double G = 0;
+#pragma omp simd reduction(+ : A0, A1, A2, A3, A4, A5, A6, A7, A8, G)
+		for (arma::uword i = 0; i < xyz.n_cols; ++i)
+		{
+			const double x = xyz.at(0, i) - cx, y = xyz.at(1, i) - cy, z = xyz.at(2, i) - cz;
+			const double x_t = target.at(0, i) - tx, y_t = target.at(1, i) - ty,
+						 z_t = target.at(2, i) - tz;
+
+			G += x * x + y * y + z * z + x_t * x_t + y_t * y_t + z_t * z_t;
+
+			A0 += x_t * x;
+			A1 += x_t * y;
+			A2 += x_t * z;
+			A3 += y_t * x;
+			A4 += y_t * y;
+			A5 += y_t * z;
+			A6 += z_t * x;
+			A7 += z_t * y;
+			A8 += z_t * z;
+		}
+
+		result.A = { A0, A1, A2, A3, A4, A5, A6, A7, A8 };
+		result.E0 = G / 2;
+		return result;
+	}
+
+	template <typename T>
+	double qcp_self_inner_product(const arma::Mat<T>& xyz)
+	{
+		const T* data = xyz.memptr();
+		double G = 0;
+#pragma omp simd reduction(+ : G)
+		for (arma::uword i = 0; i < xyz.n_elem; ++i)
+			G += static_cast<double>(data[i]) * data[i];
+		return G;
+	}
+
+	template <typename T>
+	QCPInnerProduct qcp_inner_product(const arma::Mat<T>& xyz, const arma::Mat<T>& target,
+		double self_inner_product, double target_self_inner_product)
+	{
+		if (xyz.n_cols != target.n_cols)
+			throw "Atom number mismatch";
+
+		QCPInnerProduct result;
+		result.n_atoms = xyz.n_cols;
+
+		double A0 = 0, A1 = 0, A2 = 0, A3 = 0, A4 = 0, A5 = 0, A6 = 0, A7 = 0, A8 = 0;
+#pragma omp simd reduction(+ : A0, A1, A2, A3, A4, A5, A6, A7, A8)
+		for (arma::uword i = 0; i < xyz.n_cols; ++i)
+		{
+			const double x = xyz.at(0, i), y = xyz.at(1, i), z = xyz.at(2, i);
+			const double x_t = target.at(0, i), y_t = target.at(1, i), z_t = target.at(2, i);
+
+			A0 += x_t * x;
+			A1 += x_t * y;
+			A2 += x_t * z;
+			A3 += y_t * x;
+			A4 += y_t * y;
+			A5 += y_t * z;
+			A6 += z_t * x;
+			A7 += z_t * y;
+			A8 += z_t * z;
+		}
+
+		result.A = { A0, A1, A2, A3, A4, A5, A6, A7, A8 };
+		result.E0 = (self_inner_product + target_self_inner_product) / 2;
+		return result;
+	}
+
+	double qcp_rmsd(const QCPInnerProduct& inner_product)
+	{
+		if (inner_product.n_atoms == 0)
+			return 0;
+
+		const double eigenvalue = max_eigenvalue(inner_product);
+		return std::sqrt(
+			std::abs(2.0 * (inner_product.E0 - eigenvalue) / inner_product.n_atoms));
+	}
+
+	template <typename T>
+	arma::Mat<T> qcp_rotation(const QCPInnerProduct& inner_product)
+	{
+		arma::Mat<T> rotation = arma::eye<arma::Mat<T>>(3, 3);
+		if (inner_product.n_atoms == 0)
+			return rotation;
+
+		const double eigenvalue = max_eigenvalue(inner_product);
+
+		const auto& A = inner_product.A;
+		const double Sxx = A[0], Sxy = A[1], Sxz = A[2];
+		const double Syx = A[3], Syy = A[4], Syz = A[5];
+		const double Szx = A[6], Szy = A[7], Szz = A[8];
+
+		// the key matrix minus eigenvalue * I, whose null space is the quaternion
+		const double a11 = Sxx + Syy + Szz - eigenvalue, a12 = Syz - Szy, a13 = Szx - Sxz,
+					 a14 = Sxy - Syx;
+		const double a21 = a12, a22 = Sxx - Syy - Szz - eigenvalue, a23 = Sxy + Syx,
+					 a24 = Sxz + Szx;
+		const double a31 = a13, a32 = a23, a33 = Syy - Sxx - Szz - eigenvalue, a34 = Syz + Szy;
+		const double a41 = a14, a42 = a24, a43 = a34, a44 = Szz - Sxx - Syy - eigenvalue;
+
+		const double a3344_4334 = a33 * a44 - a43 * a34, a3244_4234 = a32 * a44 - a42 * a34;
+		const double a3243_4233 = a32 * a43 - a42 * a33, a3143_4133 = a31 * a43 - a41 * a33;
+		const double a3144_4134 = a31 * a44 - a41 * a34, a3142_4132 = a31 * a42 - a41 * a32;
+
+		// the quaternion is any non-zero column of the adjugate, try them in turn
+		std::array<double, 4> q = {
+			a22 * a3344_4334 - a23 * a3244_4234 + a24 * a3243_4233,
+			-a21 * a3344_4334 + a23 * a3144_4134 - a24 * a3143_4133,
+			a21 * a3244_4234 - a22 * a3144_4134 + a24 * a3142_4132,
+			-a21 * a3243_4233 + a22 * a3143_4133 - a23 * a3142_4132,
+		};
+		auto norm_squared
+			= [&q]() { return q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]; };
+
+		if (norm_squared() < eigenvector_precision)
+		{
+			q = {
+				a12 * a3344_4334 - a13 * a3244_4234 + a14 * a3243_4233,
+				-a11 * a3344_4334 + a13 * a3144_4134 - a14 * a3143_4133,
+				a11 * a3244_4234 - a12 * a3144_4134 + a14 * a3142_4132,
+				-a11 * a3243_4233 + a12 * a3143_4133 - a13 * a3142_4132,
+			};
+		}
+
+		if (norm_squared() < eigenvector_precision)
+		{
+			const double a1324_1423 = a13 * a24 - a14 * a23, a1224_1422 = a12 * a24 - a14 * a22;
+			const double a1223_1322 = a12 * a23 - a13 * a22, a1124_1421 = a11 * a24 - a14 * a21;
+			const double a1123_1321 = a11 * a23 - a13 * a21, a1122_1221 = a11 * a22 - a12 * a21;
+
+			q = {
+				a42 * a1324_1423 - a43 * a1224_1422 + a44 * a1223_1322,
+				-a41 * a1324_1423 + a43 * a1124_1421 - a44 * a1123_1321,
+				a41 * a1224_1422 - a42 * a1124_1421 + a44 * a1122_1221,
+				-a41 * a1223_1322 + a42 * a1123_1321 - a43 * a1122_1221,
+			};
+
+			if (norm_squared() < eigenvector_precision)
+			{
+				q = {
+					a32 * a1324_1423 - a33 * a1224_1422 + a34 * a1223_1322,
+					-a31 * a1324_1423 + a33 * a1124_1421 - a34 * a1123_1321,
+					a31 * a1224_1422 - a32 * a1124_1421 + a34 * a1122_1221,
+					-a31 * a1223_1322 + a32 * a1123_1321 - a33 * a1122_1221,
+				};
+			}
+		}
+
+		const double q_norm_squared = norm_squared();
+		// the coordinate sets are already superposed (or degenerate)
+		if (q_norm_squared < eigenvector_precision)
+			return rotation;
+
+		const double norm = std::sqrt(q_norm_squared);
+		const double q1 = q[0] / norm, q2 = q[1] / norm, q3 = q[2] / norm, q4 = q[3] / norm;
+
+		const double a2 = q1 * q1, x2 = q2 * q2, y2 = q3 * q3, z2 = q4 * q4;
+		const double xy = q2 * q3, az = q1 * q4, zx = q4 * q2;
+		const double ay = q1 * q3, yz = q3 * q4, ax = q1 * q2;
+
+		rotation.at(0, 0) = a2 + x2 - y2 - z2;
+		rotation.at(0, 1) = 2 * (xy + az);
+		rotation.at(0, 2) = 2 * (zx - ay);
+		rotation.at(1, 0) = 2 * (xy - az);
+		rotation.at(1, 1) = a2 - x2 + y2 - z2;
+		rotation.at(1, 2) = 2 * (yz + ax);
+		rotation.at(2, 0) = 2 * (zx + ay);
+		rotation.at(2, 1) = 2 * (yz - ax);
+		rotation.at(2, 2) = a2 - x2 - y2 + z2;
+
+		return rotation;
+	}
+
+	template QCPInnerProduct qcp_inner_product(const arma::Mat<float>&, const arma::Col<float>&,
+		const arma::Mat<float>&, const arma::Col<float>&);
+	template QCPInnerProduct qcp_inner_product(const arma::Mat<double>&,
+		const arma::Col<double>&, const arma::Mat<double>&, const arma::Col<double>&);
+
+	template double qcp_self_inner_product(const arma::Mat<float>&);
+	template double qcp_self_inner_product(const arma::Mat<double>&);
+
+	template QCPInnerProduct qcp_inner_product(
+		const arma::Mat<float>&, const arma::Mat<float>&, double, double);
+	template QCPInnerProduct qcp_inner_product(
+		const arma::Mat<double>&, const arma::Mat<double>&, double, double);
+
+	template arma::Mat<float> qcp_rotation(const QCPInnerProduct&);
+	template arma::Mat<double> qcp_rotation(const QCPInnerProduct&);
+}
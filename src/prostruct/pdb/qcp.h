@@ -0,0 +1,65 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_QCP_H
+#define PROSTRUCT_QCP_H
+
+#include <armadillo>
+
+#include <array>
+
+namespace prostruct::geometry
+{
+	/**
+	 * The inner products of two centred coordinate sets that the Quaternion
+	 * Characteristic Polynomial method (Theobald, 2005) needs to find their
+	 * optimal superposition. They are accumulated in double precision, since
+	 * the RMSD is found from the difference of two large numbers.
+	 */
+	struct QCPInnerProduct
+	{
+		/** A[3 * a + b] is the sum of target_a * xyz_b, e.g. A[1] is sum(x_target * y) */
+		std::array<double, 9> A {};
+		/** half the sum of the squared norms of both coordinate sets */
+		double E0 = 0;
+		arma::uword n_atoms = 0;
+	};
+
+	/**
+	 * The inner products of xyz and target, which are centred on the fly with
+	 * the given centroids (without copying the coordinates).
+	 */
+	template <typename T>
+	QCPInnerProduct qcp_inner_product(const arma::Mat<T>& xyz, const arma::Col<T>& centroid,
+		const arma::Mat<T>& target, const arma::Col<T>& target_centroid);
+
+	/** The sum of the squared norms of the (already centred) coordinates xyz */
+	template <typename T>
+	double qcp_self_inner_product(const arma::Mat<T>& xyz);
+
+	/**
+	 * The inner products of xyz and target that are already centred, given
+	 * their self inner products (see qcp_self_inner_product), so that these are
+	 * computed once per structure when comparing many structures.
+	 */
+	template <typename T>
+	QCPInnerProduct qcp_inner_product(const arma::Mat<T>& xyz, const arma::Mat<T>& target,
+		double self_inner_product, double target_self_inner_product);
+
+	/** The RMSD of the optimal superposition of xyz onto target */
+	double qcp_rmsd(const QCPInnerProduct& inner_product);
+
+	/**
+	 * The 3 x 3 rotation that superposes the centred xyz onto the centred target.
+	 * This is only needed to move coordinates, qcp_rmsd does not compute it.
+	 */
+	template <typename T>
+	arma::Mat<T> qcp_rotation(const QCPInnerProduct& inner_product);
+}
+
+#endif // PROSTRUCT_QCP_H
@@ -6,27 +6,56 @@
  *
  */
 
-#include <prostruct/core/kernels.h>
 #include <prostruct/pdb/geometry.h>
+#include <prostruct/pdb/qcp.h>
+
+#include <numeric>
 
 namespace prostruct
 {
 	namespace geometry
 	{
 
+		namespace
+		{
+			// the squared deviations are summed in blocks of a fixed size, and the
+			// block sums are added in order, so the result does not depend on the
+			// number of threads
+			constexpr arma::uword rmsd_block_size = 4096;
+		}
+
 		template <typename T>
 		T rmsd(const arma::Mat<T>& xyz, const arma::Mat<T>& xyz_other)
 		{
-
-			T sum = 0.0;
-
-#pragma omp parallel for reduction(+ : sum)
-			for (arma::uword i = 0; i < xyz.n_cols; ++i)
+			if (xyz.n_elem != xyz_other.n_elem)
+				throw "Atom number mismatch";
+			if (xyz.n_cols == 0)
+				return 0;
+
+			// the columns are contiguous, so the deviations of all the coordinates
+			// are one stream of 3 * n_atoms values
+			const T* a = xyz.memptr();
+			const T* b = xyz_other.memptr();
+			const arma::uword n_elem = xyz.n_elem;
+			const arma::uword n_blocks = (n_elem + rmsd_block_size - 1) / rmsd_block_size;
+			std::vector<double> block_sums(n_blocks);
+
+#pragma omp parallel for if (n_blocks > 1)
+			for (arma::uword block = 0; block < n_blocks; ++block)
 			{
-				sum += kernels::distance_lazy<T>(xyz.col(i), xyz_other.col(i));
+				const arma::uword end = std::min(n_elem, (block + 1) * rmsd_block_size);
+				double sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+				for (arma::uword i = block * rmsd_block_size; i < end; ++i)
+				{
+					const double deviation = static_cast<double>(a[i]) - b[i];
+					sum += deviation * deviation;
+				}
+				block_sums[block] = sum;
 			}
 
-			return std::sqrt(sum / xyz.n_cols);
+			const double sum = std::accumulate(block_sums.cbegin(), block_sums.cend(), 0.0);
+			return static_cast<T>(std::sqrt(sum / xyz.n_cols));
 		}
 
 		template <typename T>
@@ -92,45 +121,120 @@ namespace prostruct
 		}
 
 		template <typename T>
-		void kabsch_rotation_(arma::Mat<T>& xyz, arma::Mat<T>& other_xyz)
+		void kabsch_rotation_(arma::Mat<T>& xyz, const arma::Mat<T>& other_xyz)
 		{
+			// the optimal rotation is found with QCP from the inner products of
+			// the centred coordinates, see qcp.cpp
+			arma::Col<T> centroid(3);
+			arma::Col<T> other_centroid(3);
+			get_centroid(xyz, centroid);
+			get_centroid(other_xyz, other_centroid);
 
-			// source: https://en.wikipedia.org/wiki/Kabsch_algorithm
-
-			arma::Mat<T> xyz_1(3, xyz.n_cols);
-			arma::Mat<T> xyz_2(3, xyz.n_cols);
-
-			recentre_molecule(xyz, xyz_1);
-			recentre_molecule(other_xyz, xyz_2);
-
-			arma::Mat<T> A = xyz_1 * xyz_2.t();
+			const auto inner_product
+				= qcp_inner_product(xyz, centroid, other_xyz, other_centroid);
 
-			arma::Mat<T> U;
-			arma::Col<T> s;
-			arma::Mat<T> V;
+			// and apply rotation to the coordinate system
+			xyz = qcp_rotation<T>(inner_product) * xyz;
+		}
 
-			// First, calculate the SVD of the covariance matrix A.
-			arma::svd(U, s, V, A);
+		template <typename T>
+		T kabsch_rmsd_(const arma::Mat<T>& xyz, const arma::Mat<T>& other_xyz)
+		{
+			arma::Col<T> centroid(3);
+			arma::Col<T> other_centroid(3);
+			get_centroid(xyz, centroid);
+			get_centroid(other_xyz, other_centroid);
 
-			// Next, decide whether we need to correct our rotation matrix to
-			// ensure a right-handed coordinate system
-			arma::Mat<T> I = arma::eye<arma::Mat<T>>(3, 3);
-			I.at(2, 2) = arma::det(V * U.t()) > 0 ? 1 : -1;
+			// the RMSD follows from the inner products, without rotating xyz
+			return qcp_rmsd(qcp_inner_product(xyz, centroid, other_xyz, other_centroid));
+		}
 
-			// Finally, calculate our optimal rotation matrix -> rotationMatrix
-			arma::Mat<T> rotationMatrix = V * I * U.t();
+		namespace
+		{
+			// a tile of frames is sized so that two tiles of coordinates stay in a
+			// (256 KiB) L2 cache while all the pairs between them are compared
+			constexpr size_t tile_bytes = 128 * 1024;
+
+			/**
+			 * Calls f(i, j) for every pair of frames i < j. The pairs are grouped in
+			 * tiles of frames, and the tiles are spread over threads.
+			 */
+			template <typename T, typename F>
+			void for_each_frame_pair(const arma::Cube<T>& frames, F&& f)
+			{
+				const arma::uword n_frames = frames.n_slices;
+				const size_t frame_bytes
+					= std::max<size_t>(frames.n_rows * frames.n_cols * sizeof(T), 1);
+				const arma::uword tile = std::max<arma::uword>(tile_bytes / frame_bytes, 1);
+				const arma::uword n_tiles = (n_frames + tile - 1) / tile;
+
+				std::vector<std::pair<arma::uword, arma::uword>> tiles;
+				for (arma::uword tile_i = 0; tile_i < n_tiles; ++tile_i)
+				{
+					for (arma::uword tile_j = tile_i; tile_j < n_tiles; ++tile_j)
+						tiles.emplace_back(tile_i, tile_j);
+				}
+
+#pragma omp parallel for schedule(dynamic)
+				for (size_t t = 0; t < tiles.size(); ++t)
+				{
+					const arma::uword i_end = std::min((tiles[t].first + 1) * tile, n_frames);
+					const arma::uword j_end = std::min((tiles[t].second + 1) * tile, n_frames);
+					const arma::uword j_begin = tiles[t].second * tile;
+					for (arma::uword i = tiles[t].first * tile; i < i_end; ++i)
+					{
+						for (arma::uword j = std::max(j_begin, i + 1); j < j_end; ++j)
+							f(i, j);
+					}
+				}
+			}
 
-			// and apply rotation to the coordinate system
-			xyz = rotationMatrix * xyz;
+			/**
+			 * Calls f(i, j, rmsd) with the superposed RMSD of every pair of frames
+			 * i < j. The frames are centred, and their self inner products computed,
+			 * once.
+			 */
+			template <typename T, typename F>
+			void for_each_frame_rmsd(const arma::Cube<T>& frames, F&& f)
+			{
+				arma::Cube<T> centred(frames);
+				std::vector<double> self_inner_products(frames.n_slices);
+
+#pragma omp parallel for
+				for (arma::uword i = 0; i < frames.n_slices; ++i)
+				{
+					recentre_molecule(centred.slice(i));
+					self_inner_products[i] = qcp_self_inner_product(centred.slice(i));
+				}
+
+				for_each_frame_pair(centred, [&](arma::uword i, arma::uword j) {
+					const auto inner_product = qcp_inner_product(centred.slice(i),
+						centred.slice(j), self_inner_products[i], self_inner_products[j]);
+					f(i, j, static_cast<T>(qcp_rmsd(inner_product)));
+				});
+			}
 		}
 
 		template <typename T>
-		T kabsch_rmsd_(arma::Mat<T>& xyz, arma::Mat<T>& other_xyz)
+		arma::Mat<T> rmsd_matrix(const arma::Cube<T>& frames)
 		{
+			arma::Mat<T> result(frames.n_slices, frames.n_slices, arma::fill::zeros);
+			for_each_frame_rmsd(frames, [&result](arma::uword i, arma::uword j, T value) {
+				result.at(i, j) = value;
+				result.at(j, i) = value;
+			});
+			return result;
+		}
 
-			kabsch_rotation_(xyz, other_xyz);
-
-			return rmsd(xyz, other_xyz);
+		template <typename T>
+		arma::Col<T> condensed_rmsd_matrix(const arma::Cube<T>& frames)
+		{
+			const arma::uword n = frames.n_slices;
+			arma::Col<T> result(n * (n - std::min<arma::uword>(n, 1)) / 2);
+			for_each_frame_rmsd(frames, [&result, n](arma::uword i, arma::uword j, T value) {
+				result.at(n * i - i * (i + 1) / 2 + j - i - 1) = value;
+			});
+			return result;
 		}
 
 		template float rmsd(const arma::Mat<float>&, const arma::Mat<float>&);
@@ -141,15 +245,20 @@ namespace prostruct
 
 		template void get_centroid(const arma::Mat<double>&, arma::Col<double>&);
 
-		template float kabsch_rmsd_(arma::Mat<float>&, arma::Mat<float>&);
-		template double kabsch_rmsd_(arma::Mat<double>&, arma::Mat<double>&);
+		template float kabsch_rmsd_(const arma::Mat<float>&, const arma::Mat<float>&);
+		template double kabsch_rmsd_(const arma::Mat<double>&, const arma::Mat<double>&);
 
-		template void kabsch_rotation_(arma::Mat<float>&, arma::Mat<float>&);
-		template void kabsch_rotation_(arma::Mat<double>&, arma::Mat<double>&);
+		template void kabsch_rotation_(arma::Mat<float>&, const arma::Mat<float>&);
+		template void kabsch_rotation_(arma::Mat<double>&, const arma::Mat<double>&);
 
 		template void recentre_molecule(arma::Mat<float>&);
 
 		template void recentre_molecule(arma::Mat<double>&);
 
+		template arma::Mat<float> rmsd_matrix(const arma::Cube<float>&);
+		template arma::Mat<double> rmsd_matrix(const arma::Cube<double>&);
+
+		template arma::Col<float> condensed_rmsd_matrix(const arma::Cube<float>&);
+		template arma::Col<double> condensed_rmsd_matrix(const arma::Cube<double>&);
 	}
 }
\ No newline at end of file
@@ -6,118 +6,67 @@
  *
  */
 
+#include "prostruct/pdb/cell_list.h"
 #include "prostruct/pdb/geometry.h"
+#include "prostruct/pdb/sasa_kernel.h"
 #include "prostruct/struct/atom.h"
 
 namespace prostruct
 {
 	namespace geometry
 	{
-
-		constexpr double golden_angle = 2.399963229728653;
-
-		template <typename T>
-		void generate_sphere(arma::Mat<T>& result)
+		namespace
 		{
+			// theoretical maximum accessible surface area (A^2) of each residue,
+			// in the order of AminoAcid, from Tien et al. (2013), PLoS ONE 8(11): e80635
+			constexpr std::array<double, 20> max_asa_table = { 274.0, 129.0, 195.0, 193.0, 167.0,
+				225.0, 223.0, 104.0, 224.0, 197.0, 201.0, 236.0, 224.0, 240.0, 159.0, 155.0, 172.0,
+				285.0, 263.0, 174.0 };
+		}
 
-			T offset = 2.0 / result.n_cols;
-
-			for (arma::uword i = 0; i < result.n_cols; ++i)
-			{
-
-				T y = i * offset - 1.0 + (offset / 2.0);
-				T r = std::sqrt(1.0 - y * y);
-
-				T t = i * golden_angle;
-
-				result.at(0, i) = r * std::cos(t); // x
-				result.at(1, i) = y; // y
-				result.at(2, i) = r * std::sin(t); // z
-			}
+		double max_asa(AminoAcid amino_acid) noexcept
+		{
+			return max_asa_table[static_cast<int>(amino_acid)];
 		}
 
 		template <typename T>
-		void calculate_atom_SASA(const arma::Mat<T>& xyz, const arma::Col<T>& radius,
-			const arma::subview_col<T>& neighbours, const arma::uword current_atom_index,
-			const T probe, const arma::Mat<T>& sphere_points, const T adjustment, arma::Col<T>& asa)
+		void shrake_rupley(const arma::Mat<T>& xyz, const arma::Col<T>& radii, arma::Col<T>& asa,
+			arma::uword n_atoms, T probe, arma::uword n_sphere_points)
 		{
 
-			arma::Col<T> atom_XYZ = xyz.col(current_atom_index);
-			arma::uvec neighbourIndices = arma::find(neighbours, 0);
+			const auto& sphere_points = cached_sphere_points<T>(n_sphere_points);
 
-			T atomRadius = probe + radius.at(current_atom_index);
-			arma::uword nNeighbours = neighbourIndices.size();
-			arma::uword accessiblePoints = 0;
+			// atoms are neighbours if their van der Waals spheres overlap
+			const auto neighbours = neighbour_list(xyz, radii);
 
-			arma::uword k = 0;
+			const T adjustment = 4.0 * M_PI / n_sphere_points;
+			const auto simd_level = detected_simd_level();
 
-			for (arma::uword i = 0; i < sphere_points.n_cols; ++i)
+#pragma omp parallel
 			{
-				for (arma::uword j = k; j < nNeighbours + k; ++j)
-				{
+				NeighbourSpheres<T> neighbour_spheres;
 
-					arma::uword index = neighbourIndices.at(j % nNeighbours);
-					T r_2 = std::pow(radius.at(index) + probe, 2);
-					T dist = arma::sum(
-						arma::square((sphere_points(arma::span::all, i) * atomRadius + atom_XYZ)
-							- xyz.col(index)));
+#pragma omp for schedule(dynamic, 64)
+				for (arma::uword i = 0; i < n_atoms; ++i)
+				{
+					const T atom_radius = probe + radii.at(i);
 
-					if (dist < r_2)
+					neighbour_spheres.clear();
+					for (auto j = neighbours.begin(i); j != neighbours.end(i); ++j)
 					{
-						k = j;
-						goto BURRIED;
+						neighbour_spheres.push_back(xyz.at(0, *j) - xyz.at(0, i),
+							xyz.at(1, *j) - xyz.at(1, i), xyz.at(2, *j) - xyz.at(2, i),
+							radii.at(*j) + probe);
 					}
-				}
-				accessiblePoints++;
-			BURRIED:
-				continue;
-			}
 
-			asa.at(current_atom_index) = adjustment * accessiblePoints * std::pow(atomRadius, 2);
-		}
+					const auto accessible_points = count_accessible_points(
+						sphere_points, atom_radius, neighbour_spheres, simd_level);
 
-		template <typename T>
-		void get_neighbours(const arma::Mat<T>& xyz, arma::Mat<T>& neighbours, int n_atoms,
-			const arma::Col<T>& radii)
-		{
-#pragma omp parallel for
-			for (arma::uword i = 0; i < n_atoms; ++i)
-			{
-				for (arma::uword j = 1; j < n_atoms; ++j)
-				{
-					T cutoff = std::pow(radii.at(i) + radii.at(j), 2);
-					if (arma::sum(arma::square(xyz(arma::span::all, i) - xyz(arma::span::all, j)))
-						< cutoff)
-					{
-						neighbours.at(i, j) = 1;
-						neighbours.at(j, i) = 1;
-					}
+					asa.at(i) = adjustment * accessible_points * atom_radius * atom_radius;
 				}
 			}
 		}
 
-		template <typename T>
-		void shrake_rupley(const arma::Mat<T>& xyz, const arma::Col<T>& radii, arma::Col<T>& asa,
-			arma::uword n_atoms, T probe, arma::uword n_sphere_points)
-		{
-
-			arma::Mat<T> sphere_points(3, n_sphere_points);
-			arma::Mat<T> neighbours(n_atoms, n_atoms);
-
-			generate_sphere(sphere_points);
-
-			get_neighbours(xyz, neighbours, n_atoms, radii);
-
-			T adjustment = 4.0 * M_PI / n_sphere_points;
-
-#pragma omp parallel for
-			for (arma::uword i = 0; i < n_atoms; ++i)
-			{
-				calculate_atom_SASA(
-					xyz, radii, neighbours.col(i), i, probe, sphere_points, adjustment, asa);
-			}
-		}
-
 		template void shrake_rupley(const arma::Mat<float>&, const arma::Col<float>&,
 			arma::Col<float>&, arma::uword n_atoms, float probe, arma::uword n_sphere_points);
 
@@ -0,0 +1,320 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/pdb/sasa_kernel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PROSTRUCT_SASA_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace prostruct::geometry
+{
+	namespace
+	{
+		constexpr double golden_angle = 2.399963229728653;
+
+		/**
+		 * The neighbours are tested starting with the one that buried the previous
+		 * point (or block of points), as neighbouring points are usually buried by
+		 * the same atom.
+		 */
+		template <typename T>
+		arma::uword count_accessible_scalar(const SpherePoints<T>& sphere, T radius,
+			const NeighbourSpheres<T>& neighbours)
+		{
+			const arma::uword n_neighbours = neighbours.size();
+			arma::uword accessible = 0;
+			arma::uword start = 0;
+
+			for (arma::uword i = 0; i < sphere.n_points; ++i)
+			{
+				const T x = sphere.x[i] * radius;
+				const T y = sphere.y[i] * radius;
+				const T z = sphere.z[i] * radius;
+				bool buried = false;
+
+				for (arma::uword k = 0; k < n_neighbours; ++k)
+				{
+					arma::uword j = start + k;
+					if (j >= n_neighbours)
+						j -= n_neighbours;
+					const T dx = x - neighbours.x[j];
+					const T dy = y - neighbours.y[j];
+					const T dz = z - neighbours.z[j];
+					if (dx * dx + dy * dy + dz * dz < neighbours.radius_2[j])
+					{
+						start = j;
+						buried = true;
+						break;
+					}
+				}
+				accessible += !buried;
+			}
+			return accessible;
+		}
+
+#ifdef PROSTRUCT_SASA_X86_KERNELS
+		// each kernel tests a block of sphere points against one neighbour at a time,
+		// and moves on to the next block once all of its points are buried
+
+		__attribute__((target("avx2"))) arma::uword count_accessible_avx2(
+			const SpherePoints<float>& sphere, float radius,
+			const NeighbourSpheres<float>& neighbours)
+		{
+			constexpr arma::uword width = 8;
+			constexpr int all_buried = 0xFF;
+			const arma::uword n_neighbours = neighbours.size();
+			const __m256 r = _mm256_set1_ps(radius);
+			arma::uword accessible = 0;
+			arma::uword start = 0;
+
+			for (arma::uword i = 0; i < sphere.n_points; i += width)
+			{
+				const __m256 x = _mm256_mul_ps(_mm256_loadu_ps(sphere.x.data() + i), r);
+				const __m256 y = _mm256_mul_ps(_mm256_loadu_ps(sphere.y.data() + i), r);
+				const __m256 z = _mm256_mul_ps(_mm256_loadu_ps(sphere.z.data() + i), r);
+				// padding lanes count as buried
+				const arma::uword n_valid = std::min(width, sphere.n_points - i);
+				int buried = all_buried & ~((1 << n_valid) - 1);
+
+				for (arma::uword k = 0; k < n_neighbours && buried != all_buried; ++k)
+				{
+					arma::uword j = start + k;
+					if (j >= n_neighbours)
+						j -= n_neighbours;
+					const __m256 dx = _mm256_sub_ps(x, _mm256_set1_ps(neighbours.x[j]));
+					const __m256 dy = _mm256_sub_ps(y, _mm256_set1_ps(neighbours.y[j]));
+					const __m256 dz = _mm256_sub_ps(z, _mm256_set1_ps(neighbours.z[j]));
+					const __m256 distance_2 = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+						_mm256_mul_ps(dz, dz));
+					buried |= _mm256_movemask_ps(_mm256_cmp_ps(
+						distance_2, _mm256_set1_ps(neighbours.radius_2[j]), _CMP_LT_OQ));
+					if (buried == all_buried)
+						start = j;
+				}
+				accessible += n_valid - __builtin_popcount(buried & ((1 << n_valid) - 1));
+			}
+			return accessible;
+		}
+
+		__attribute__((target("avx2"))) arma::uword count_accessible_avx2(
+			const SpherePoints<double>& sphere, double radius,
+			const NeighbourSpheres<double>& neighbours)
+		{
+			constexpr arma::uword width = 4;
+			constexpr int all_buried = 0xF;
+			const arma::uword n_neighbours = neighbours.size();
+			const __m256d r = _mm256_set1_pd(radius);
+			arma::uword accessible = 0;
+			arma::uword start = 0;
+
+			for (arma::uword i = 0; i < sphere.n_points; i += width)
+			{
+				const __m256d x = _mm256_mul_pd(_mm256_loadu_pd(sphere.x.data() + i), r);
+				const __m256d y = _mm256_mul_pd(_mm256_loadu_pd(sphere.y.data() + i), r);
+				const __m256d z = _mm256_mul_pd(_mm256_loadu_pd(sphere.z.data() + i), r);
+				const arma::uword n_valid = std::min(width, sphere.n_points - i);
+				int buried = all_buried & ~((1 << n_valid) - 1);
+
+				for (arma::uword k = 0; k < n_neighbours && buried != all_buried; ++k)
+				{
+					arma::uword j = start + k;
+					if (j >= n_neighbours)
+						j -= n_neighbours;
+					const __m256d dx = _mm256_sub_pd(x, _mm256_set1_pd(neighbours.x[j]));
+					const __m256d dy = _mm256_sub_pd(y, _mm256_set1_pd(neighbours.y[j]));
+					const __m256d dz = _mm256_sub_pd(z, _mm256_set1_pd(neighbours.z[j]));
+					const __m256d distance_2 = _mm256_add_pd(
+						_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+						_mm256_mul_pd(dz, dz));
+					buried |= _mm256_movemask_pd(_mm256_cmp_pd(
+						distance_2, _mm256_set1_pd(neighbours.radius_2[j]), _CMP_LT_OQ));
+					if (buried == all_buried)
+						start = j;
+				}
+				accessible += n_valid - __builtin_popcount(buried & ((1 << n_valid) - 1));
+			}
+			return accessible;
+		}
+
+		__attribute__((target("avx512f"))) arma::uword count_accessible_avx512(
+			const SpherePoints<float>& sphere, float radius,
+			const NeighbourSpheres<float>& neighbours)
+		{
+			constexpr arma::uword width = 16;
+			constexpr int all_buried = 0xFFFF;
+			const arma::uword n_neighbours = neighbours.size();
+			const __m512 r = _mm512_set1_ps(radius);
+			arma::uword accessible = 0;
+			arma::uword start = 0;
+
+			for (arma::uword i = 0; i < sphere.n_points; i += width)
+			{
+				const __m512 x = _mm512_mul_ps(_mm512_loadu_ps(sphere.x.data() + i), r);
+				const __m512 y = _mm512_mul_ps(_mm512_loadu_ps(sphere.y.data() + i), r);
+				const __m512 z = _mm512_mul_ps(_mm512_loadu_ps(sphere.z.data() + i), r);
+				const arma::uword n_valid = std::min(width, sphere.n_points - i);
+				int buried = all_buried & ~((1 << n_valid) - 1);
+
+				for (arma::uword k = 0; k < n_neighbours && buried != all_buried; ++k)
+				{
+					arma::uword j = start + k;
+					if (j >= n_neighbours)
+						j -= n_neighbours;
+					const __m512 dx = _mm512_sub_ps(x, _mm512_set1_ps(neighbours.x[j]));
+					const __m512 dy = _mm512_sub_ps(y, _mm512_set1_ps(neighbours.y[j]));
+					const __m512 dz = _mm512_sub_ps(z, _mm512_set1_ps(neighbours.z[j]));
+					const __m512 distance_2 = _mm512_add_ps(
+						_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)),
+						_mm512_mul_ps(dz, dz));
+					buried |= _mm512_cmp_ps_mask(
+						distance_2, _mm512_set1_ps(neighbours.radius_2[j]), _CMP_LT_OQ);
+					if (buried == all_buried)
+						start = j;
+				}
+				accessible += n_valid - __builtin_popcount(buried & ((1 << n_valid) - 1));
+			}
+			return accessible;
+		}
+
+		__attribute__((target("avx512f"))) arma::uword count_accessible_avx512(
+			const SpherePoints<double>& sphere, double radius,
+			const NeighbourSpheres<double>& neighbours)
+		{
+			constexpr arma::uword width = 8;
+			constexpr int all_buried = 0xFF;
+			const arma::uword n_neighbours = neighbours.size();
+			const __m512d r = _mm512_set1_pd(radius);
+			arma::uword accessible = 0;
+			arma::uword start = 0;
+
+			for (arma::uword i = 0; i < sphere.n_points; i += width)
+			{
+				const __m512d x = _mm512_mul_pd(_mm512_loadu_pd(sphere.x.data() + i), r);
+				const __m512d y = _mm512_mul_pd(_mm512_loadu_pd(sphere.y.data() + i), r);
+				const __m512d z = _mm512_mul_pd(_mm512_loadu_pd(sphere.z.data() + i), r);
+				const arma::uword n_valid = std::min(width, sphere.n_points - i);
+				int buried = all_buried & ~((1 << n_valid) - 1);
+
+				for (arma::uword k = 0; k < n_neighbours && buried != all_buried; ++k)
+				{
+					arma::uword j = start + k;
+					if (j >= n_neighbours)
+						j -= n_neighbours;
+					const __m512d dx = _mm512_sub_pd(x, _mm512_set1_pd(neighbours.x[j]));
+					const __m512d dy = _mm512_sub_pd(y, _mm512_set1_pd(neighbours.y[j]));
+					const __m512d dz = _mm512_sub_pd(z, _mm512_set1_pd(neighbours.z[j]));
+					const __m512d distance_2 = _mm512_add_pd(
+						_mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)),
+						_mm512_mul_pd(dz, dz));
+					buried |= _mm512_cmp_pd_mask(
+						distance_2, _mm512_set1_pd(neighbours.radius_2[j]), _CMP_LT_OQ);
+					if (buried == all_buried)
+						start = j;
+				}
+				accessible += n_valid - __builtin_popcount(buried & ((1 << n_valid) - 1));
+			}
+			return accessible;
+		}
+#endif
+	}
+
+	SimdLevel detected_simd_level() noexcept
+	{
+		static const SimdLevel level = []() {
+#ifdef PROSTRUCT_SASA_X86_KERNELS
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f"))
+				return SimdLevel::AVX512;
+			if (__builtin_cpu_supports("avx2"))
+				return SimdLevel::AVX2;
+#endif
+			return SimdLevel::Scalar;
+		}();
+		return level;
+	}
+
+	template <typename T>
+	SpherePoints<T>::SpherePoints(arma::uword n_points_)
+		: n_points(n_points_)
+	{
+		const arma::uword padded_size
+			= (n_points + simd_padding - 1) / simd_padding * simd_padding;
+		x.assign(padded_size, 0);
+		y.assign(padded_size, 0);
+		z.assign(padded_size, 0);
+
+		T offset = 2.0 / n_points;
+
+		for (arma::uword i = 0; i < n_points; ++i)
+		{
+			T y_ = i * offset - 1.0 + (offset / 2.0);
+			T r = std::sqrt(1.0 - y_ * y_);
+
+			T t = i * golden_angle;
+
+			x[i] = r * std::cos(t);
+			y[i] = y_;
+			z[i] = r * std::sin(t);
+		}
+	}
+
+	template <typename T>
+	const SpherePoints<T>& cached_sphere_points(arma::uword n_points)
+	{
+		static std::mutex mutex;
+		static std::map<arma::uword, std::unique_ptr<const SpherePoints<T>>> cache;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		auto& sphere = cache[n_points];
+		if (!sphere)
+			sphere = std::make_unique<const SpherePoints<T>>(n_points);
+		return *sphere;
+	}
+
+	template <typename T>
+	arma::uword count_accessible_points(const SpherePoints<T>& sphere, T radius,
+		const NeighbourSpheres<T>& neighbours, SimdLevel level)
+	{
+		if (neighbours.size() == 0)
+			return sphere.n_points;
+
+		level = std::min(level, detected_simd_level());
+
+		switch (level)
+		{
+#ifdef PROSTRUCT_SASA_X86_KERNELS
+		case SimdLevel::AVX512:
+			return count_accessible_avx512(sphere, radius, neighbours);
+		case SimdLevel::AVX2:
+			return count_accessible_avx2(sphere, radius, neighbours);
+#endif
+		default:
+			return count_accessible_scalar(sphere, radius, neighbours);
+		}
+	}
+
+	template struct SpherePoints<float>;
+	template struct SpherePoints<double>;
+
+	template const SpherePoints<float>& cached_sphere_points(arma::uword);
+	template const SpherePoints<double>& cached_sphere_points(arma::uword);
+
+	template arma::uword count_accessible_points(
+		const SpherePoints<float>&, float, const NeighbourSpheres<float>&, SimdLevel);
+	template arma::uword count_accessible_points(
+		const SpherePoints<double>&, double, const NeighbourSpheres<double>&, SimdLevel);
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_SASA_KERNEL_H
+#define PROSTRUCT_SASA_KERNEL_H
+
+#include <armadillo>
+
+#include <vector>
+
+namespace prostruct::geometry
+{
+	/** Instruction sets that the SASA kernel can be run with */
+	enum class SimdLevel
+	{
+		Scalar,
+		AVX2,
+		AVX512
+	};
+
+	/** The best instruction set supported by the CPU, detected on the first call */
+	SimdLevel detected_simd_level() noexcept;
+
+	/**
+	 * Golden spiral points on the unit sphere, in SoA form.
+	 * The coordinates are padded with zeros to a multiple of simd_padding so that
+	 * the kernels can always load full vectors.
+	 */
+	template <typename T>
+	struct SpherePoints
+	{
+		static constexpr arma::uword simd_padding = 16;
+
+		explicit SpherePoints(arma::uword n_points);
+
+		arma::uword n_points;
+		std::vector<T> x;
+		std::vector<T> y;
+		std::vector<T> z;
+	};
+
+	/**
+	 * The SpherePoints with n_points points, which are generated on the first
+	 * call and shared by all later calls (from any thread).
+	 */
+	template <typename T>
+	const SpherePoints<T>& cached_sphere_points(arma::uword n_points);
+
+	/**
+	 * The spheres (atom radius + probe) of the neighbours of an atom, with the
+	 * centres relative to the centre of that atom, in SoA form.
+	 */
+	template <typename T>
+	struct NeighbourSpheres
+	{
+		void clear() noexcept
+		{
+			x.clear();
+			y.clear();
+			z.clear();
+			radius_2.clear();
+		}
+
+		void push_back(T x_, T y_, T z_, T radius)
+		{
+			x.push_back(x_);
+			y.push_back(y_);
+			z.push_back(z_);
+			radius_2.push_back(radius * radius);
+		}
+
+		arma::uword size() const noexcept { return x.size(); }
+
+		std::vector<T> x;
+		std::vector<T> y;
+		std::vector<T> z;
+		std::vector<T> radius_2; /**< squared radii */
+	};
+
+	/**
+	 * Counts the points of sphere, scaled by radius, that are not inside any of
+	 * the neighbour spheres. Levels that the CPU does not support fall back to
+	 * the best supported one.
+	 */
+	template <typename T>
+	arma::uword count_accessible_points(const SpherePoints<T>& sphere, T radius,
+		const NeighbourSpheres<T>& neighbours, SimdLevel level = detected_simd_level());
+}
+
+#endif // PROSTRUCT_SASA_KERNEL_H
@@ -19,6 +19,9 @@
 
 #include <fmt/format.h>
 
+#include <memory>
+#include <new>
+
 using namespace prostruct;
 
 namespace prostruct
@@ -29,6 +32,65 @@ namespace prostruct
 	public:
 		StructBase() {};
 
+#ifndef SWIG
+		/**
+		 * A structure made of the atoms [first_atom, first_atom + n_atoms) of
+		 * table. The coordinates and radii are views into the table, so all the
+		 * structures that share a table see the same coordinates.
+		 */
+		StructBase(std::shared_ptr<AtomTable<T>> table, arma::uword first_atom, arma::uword n_atoms)
+			: m_atom_table(std::move(table))
+			, m_first_atom(first_atom)
+			, m_xyz(m_atom_table->xyz_view(first_atom, n_atoms))
+			, m_natoms(static_cast<int>(n_atoms))
+			, m_radii(m_atom_table->radii_view(first_atom, n_atoms))
+		{
+		}
+
+		/**
+		 * Copies are independent of other: the AtomTable of other is copied, and
+		 * the coordinates, radii and residues of the copy are views into the new
+		 * table, so transforming the copy does not move other.
+		 * Residues that are not in the table of other are shared, as they were
+		 * before structures were backed by a table.
+		 */
+		StructBase(const StructBase& other)
+			: m_atom_table(
+				other.m_atom_table ? std::make_shared<AtomTable<T>>(*other.m_atom_table) : nullptr)
+			, m_first_atom(other.m_first_atom)
+			, m_xyz(table_xyz(m_atom_table, other))
+			, m_natoms(other.m_natoms)
+			, m_nresidues(other.m_nresidues)
+			, m_radii(table_radii(m_atom_table, other))
+			, m_residues(copy_residues(m_atom_table, other))
+			, m_backbone_layout(std::atomic_load(&other.m_backbone_layout))
+		{
+		}
+
+		StructBase& operator=(const StructBase& other)
+		{
+			if (this == &other)
+				return *this;
+
+			StructBase copy(other);
+			m_atom_table = copy.m_atom_table;
+			m_first_atom = copy.m_first_atom;
+			m_natoms = copy.m_natoms;
+			m_nresidues = copy.m_nresidues;
+			m_residues = std::move(copy.m_residues);
+			std::atomic_store(&m_backbone_layout, copy.m_backbone_layout);
+			// the views into the old table cannot be assigned to (they are
+			// strict), so they are rebuilt in place as views into the new one
+			m_xyz.~Mat();
+			new (&m_xyz) arma::Mat<T>(table_xyz(m_atom_table, copy));
+			m_radii.~Col();
+			new (&m_radii) arma::Col<T>(table_radii(m_atom_table, copy));
+			return *this;
+		}
+
+		virtual ~StructBase() = default;
+#endif
+
 		virtual std::string to_string() const
 		{
 			return format(fmt("<prostruct.StructBase {} precision, with {} atoms, {} "
@@ -51,34 +113,138 @@ namespace prostruct
 			return E;
 		}
 
-		void compute_dssp() const noexcept
+#ifndef SWIG
+		/**
+		 * The two strongest backbone hydrogen bonds of each residue, as donor and
+		 * as acceptor, in linear time and memory (see compute_kabsch_sander for
+		 * the dense energy matrix).
+		 */
+		geometry::HBondList<T> compute_kabsch_sander_sparse() const
 		{
-			// arma::Mat<T> C_coords(3, m_nresidues);
-			// arma::Mat<T> O_coords(3, m_nresidues);
-			// arma::Mat<T> N_coords(3, m_nresidues);
-			// arma::Mat<T> CA_coords(3, m_nresidues);
+			return geometry::kabsch_sander_sparse(get_backbone_atoms(), donor_residues());
+		}
+#endif
+
+		/**
+		 * Backbone hydrogen bonds with an energy below threshold (kcal/mol), as a
+		 * 3 x n_bonds matrix with the acceptor residue index, the donor residue
+		 * index and the energy of each bond.
+		 */
+		arma::Mat<T> compute_hbonds(T threshold = -0.5) const
+		{
+			const auto hbonds = compute_kabsch_sander_sparse();
+			std::vector<T> coo;
 
-			// get_backbone_atoms(C_coords, O_coords, N_coords, CA_coords);
+			for (arma::uword donor = 0; donor < hbonds.n_residues(); ++donor)
+			{
+				for (const auto& bond : hbonds.donor_bonds[donor])
+				{
+					if (bond.partner == geometry::no_partner || !(bond.energy < threshold))
+						continue;
+					coo.insert(coo.end(),
+						{ static_cast<T>(bond.partner), static_cast<T>(donor), bond.energy });
+				}
+			}
+			return arma::Mat<T>(coo.data(), 3, coo.size() / 3);
+		}
 
-			auto backbone_atoms = get_backbone_atoms();
+		/**
+		 * The DSSP secondary structure code of each residue: H (alpha helix),
+		 * B (isolated beta bridge), E (strand), G (3-10 helix), I (pi helix),
+		 * T (turn), S (bend) or a blank for a loop.
+		 */
+		std::string compute_dssp() const
+		{
+			return geometry::dssp(
+				get_backbone_atoms(), compute_kabsch_sander_sparse(), chain_starts());
+		}
 
-			// geometry::dssp(C_coords, O_coords, N_coords, CA_coords);
-			// geometry::dssp(xyz, backbone_atoms);
+		/**
+		 * The DSSP sheet label of each residue (A to Z): residues of ladders
+		 * and bridges that share a residue are in the same sheet. Residues that
+		 * are not in a ladder or bridge have a blank.
+		 */
+		std::string compute_dssp_sheets() const
+		{
+			std::string codes, sheets;
+			geometry::dssp(get_backbone_atoms(), compute_kabsch_sander_sparse(), chain_starts(),
+				codes, sheets);
+			return sheets;
 		}
 
 		arma::Mat<T> get_xyz() const noexcept { return m_xyz; }
 
+#ifndef SWIG
+		/** The coordinates without a copy, e.g. for a geometry::Superposer */
+		const arma::Mat<T>& xyz_ref() const noexcept { return m_xyz; }
+#endif
+
+		/** Indices of the atoms that are not hydrogens */
+		arma::Col<arma::uword> get_heavy_atom_indices() const
+		{
+			std::vector<arma::uword> result;
+			result.reserve(m_natoms);
+			if (m_atom_table)
+			{
+				for (arma::uword i = 0; i < static_cast<arma::uword>(m_natoms); ++i)
+				{
+					if (m_atom_table->element(m_first_atom + i) != 1)
+						result.push_back(i);
+				}
+				return arma::Col<arma::uword>(result);
+			}
+
+			// structures built from residues (e.g. the Chain constructors that take
+			// a vector of residues) have no table of their own: their atoms are
+			// those of each residue in turn, in the order of the residue's table
+			arma::uword offset = 0;
+			for (const auto& residue : m_residues)
+			{
+				const auto& table = residue->get_atom_table();
+				const arma::uword n_atoms = static_cast<arma::uword>(residue->n_atoms());
+				for (arma::uword i = 0; i < n_atoms; ++i)
+				{
+					if (table->element(residue->first_atom() + i) != 1)
+						result.push_back(offset + i);
+				}
+				offset += n_atoms;
+			}
+			if (offset != static_cast<arma::uword>(m_natoms))
+				throw "Expected the atoms of the residues to make up the structure";
+			return arma::Col<arma::uword>(result);
+		}
+
 		int n_residues() const noexcept { return m_nresidues; }
 
 		int n_atoms() const noexcept { return m_natoms; }
 
 		arma::Col<T> get_radii() const noexcept { return m_radii; }
 
+		/**
+		 * The coordinates and radii without a copy. The views follow the changes
+		 * of the structure (e.g. the frames of a Trajectory) and are valid for as
+		 * long as the structure is; in Python they are read-only NumPy arrays
+		 * that keep the structure alive.
+		 */
+		const arma::Mat<T>& get_xyz_view() const noexcept { return m_xyz; }
+
+		const arma::Col<T>& get_radii_view() const noexcept { return m_radii; }
+
 		std::vector<std::shared_ptr<Residue<T>>> get_residues() const noexcept
 		{
 			return m_residues;
 		}
 
+#ifndef SWIG
+		/**
+		 * The table that stores the atoms of this structure, which are the
+		 * atoms [first_atom(), first_atom() + n_atoms()) of the table.
+		 */
+		std::shared_ptr<AtomTable<T>> get_atom_table() const noexcept { return m_atom_table; }
+
+		arma::uword first_atom() const noexcept { return m_first_atom; }
+#endif
+
 		arma::Col<T> compute_shrake_rupley(T probe = 1.4, int n_sphere_points = 960) const noexcept
 		{
 			arma::Col<T> asa(static_cast<arma::uword>(m_natoms));
@@ -89,6 +255,32 @@ namespace prostruct
 			return asa;
 		}
 
+		/**
+		 * Solvent accessible surface area of each residue, i.e. the sum of
+		 * compute_shrake_rupley over the atoms of the residue.
+		 */
+		arma::Col<T> compute_residue_sasa(T probe = 1.4, int n_sphere_points = 960) const noexcept
+		{
+			return sum_residue_sasa(compute_shrake_rupley(probe, n_sphere_points));
+		}
+
+		/**
+		 * Relative solvent accessibility of each residue: the residue SASA divided
+		 * by the maximum SASA of its amino acid (Tien et al., 2013).
+		 */
+		arma::Col<T> compute_relative_sasa(T probe = 1.4, int n_sphere_points = 960) const noexcept
+		{
+			arma::Col<T> result = compute_residue_sasa(probe, n_sphere_points);
+			for (arma::uword i = 0; i < result.n_elem; ++i)
+				result.at(i) /= geometry::max_asa(m_residues[i]->get_amino_acid_type());
+			return result;
+		}
+
+		T compute_total_sasa(T probe = 1.4, int n_sphere_points = 960) const noexcept
+		{
+			return arma::accu(compute_shrake_rupley(probe, n_sphere_points));
+		}
+
 		T calculate_RMSD(StructBase<T>& other) const
 		{
 			// first check if the size is the same
@@ -109,44 +301,99 @@ namespace prostruct
 
 		void recentre() noexcept { geometry::recentre_molecule(m_xyz); }
 
+		/**
+		 * The phi (first row) and psi (second row) torsions, where column i has
+		 * the phi of residue i + 1 and the psi of residue i.
+		 */
 		arma::Mat<T> calculate_phi_psi(bool use_radians = false) const noexcept
 		{
-			return core::residue_kernel_engine(m_residues, 0, kernels::phi_kernel<T>(use_radians),
-				kernels::psi_kernel<T>(use_radians));
+			return calculate_backbone_torsions(use_radians).head_rows(2);
 		}
 
-		void kabsch_rotation(StructBase<T>& other) noexcept
+		/**
+		 * The phi, psi and omega torsions (rows), with the columns of
+		 * calculate_phi_psi, computed directly from the backbone coordinates.
+		 */
+		arma::Mat<T> calculate_backbone_torsions(bool use_radians = false) const noexcept
 		{
-			// make copy of xyz
-			auto xyz_copy = other.get_xyz();
-			geometry::kabsch_rotation_(m_xyz, xyz_copy);
+			arma::Mat<T> result;
+			calculate_backbone_torsions(result, use_radians);
+			return result;
 		}
 
-		T kabsch_rmsd(StructBase<T>& other) const noexcept
+#ifndef SWIG
+		/**
+		 * As calculate_backbone_torsions, into result, which is only allocated if
+		 * it is not 3 x n_residues. The backbone is read in place, at positions
+		 * that are found on the first call and then cached (see backbone_layout),
+		 * so calls for each frame of a Trajectory do not allocate.
+		 */
+		void calculate_backbone_torsions(arma::Mat<T>& result, bool use_radians = false) const
 		{
-			// make copy of xyz
-			auto xyz_copy = m_xyz;
-			auto xyz_other_copy = other.get_xyz();
+			const auto layout = backbone_layout();
+			geometry::backbone_torsions(
+				m_xyz, layout->first_atoms, layout->chain_start, use_radians, result);
+		}
+#endif
 
-			return geometry::kabsch_rmsd_(xyz_copy, xyz_other_copy);
+		void kabsch_rotation(StructBase<T>& other)
+		{
+			geometry::kabsch_rotation_(m_xyz, other.m_xyz);
 		}
 
+		T kabsch_rmsd(StructBase<T>& other) const
+		{
+			return geometry::kabsch_rmsd_(m_xyz, other.m_xyz);
+		}
+
+#ifndef SWIG
+		/**
+		 * Superposed RMSD of every pair of structures, which must have the same
+		 * number of atoms (see geometry::rmsd_matrix).
+		 */
+		template <typename Structure>
+		static arma::Mat<T> kabsch_rmsd_matrix(
+			const std::vector<std::shared_ptr<Structure>>& structures)
+		{
+			return geometry::rmsd_matrix(stack_frames(structures));
+		}
+
+		/** The upper triangle of kabsch_rmsd_matrix, row by row */
+		template <typename Structure>
+		static arma::Col<T> condensed_kabsch_rmsd_matrix(
+			const std::vector<std::shared_ptr<Structure>>& structures)
+		{
+			return geometry::condensed_rmsd_matrix(stack_frames(structures));
+		}
+#endif
+
 		arma::Col<T> calculate_phi(bool use_radians = false) const noexcept
 		{
-			// result is a matrix where each row has the lambda/kernel result for each
-			// residue, so transform it into column vector
-			return arma::Col<T>(
-				core::residue_kernel_engine(m_residues, 0, kernels::phi_kernel<T>(use_radians))
-					.memptr(),
-				m_nresidues);
+			return calculate_backbone_torsions(use_radians).row(0).t();
 		}
 
 		arma::Col<T> calculate_psi(bool use_radians = false) const noexcept
 		{
-			return arma::Col<T>(
-				core::residue_kernel_engine(m_residues, 0, kernels::psi_kernel<T>(use_radians))
-					.memptr(),
-				m_nresidues);
+			return calculate_backbone_torsions(use_radians).row(1).t();
+		}
+
+		arma::Col<T> calculate_omega(bool use_radians = false) const noexcept
+		{
+			return calculate_backbone_torsions(use_radians).row(2).t();
+		}
+
+		/**
+		 * All the torsion angles of each residue, computed in a single pass: the
+		 * rows are phi, psi, omega and chi1 to chi5, with the same values as
+		 * calculate_phi, calculate_psi, ..., calculate_chi5.
+		 */
+		arma::Mat<T> calculate_torsions(bool use_radians = false) const noexcept
+		{
+			return core::residue_kernel_engine(m_residues, 0, kernels::phi_kernel<T>(use_radians),
+				kernels::psi_kernel<T>(use_radians), kernels::omega_kernel<T>(use_radians),
+				kernels::chi1_kernel<T>(use_radians), kernels::chi2_kernel<T>(use_radians),
+				kernels::chi3_kernel<T>(use_radians), kernels::chi4_kernel<T>(use_radians),
+				kernels::chi5_kernel<T>(use_radians));
 		}
 
 		arma::Col<T> calculate_chi1(bool use_radians = false) const noexcept
@@ -192,71 +439,68 @@ namespace prostruct
 
 		arma::Mat<T> compute_shortest_distance() const noexcept
 		{
-			auto neighbour_kernel = [](const std::shared_ptr<Residue<T>>& residue,
-										const std::shared_ptr<Residue<T>>& residue_neighbour) {
-				auto sidechain = residue->get_sidechain_atoms();
-				auto sidechain_neighbour = residue_neighbour->get_sidechain_atoms();
-				T shortest_distance = std::numeric_limits<T>::infinity();
-
-				for (arma::uword i = 0; i < sidechain.n_cols; ++i)
-				{
-					for (arma::uword j = i + 1; j < sidechain_neighbour.n_cols; ++j)
-					{
-						auto dist = kernels::distance_lazy<T>(
-							sidechain.col(i), sidechain_neighbour.col(j));
-						if (dist < shortest_distance)
-							shortest_distance = dist;
-					}
-				}
-				return shortest_distance;
-			};
-			return core::pairwise_residue_kernel_engine(m_residues, 0, neighbour_kernel).slice(0);
+			return core::pairwise_residue_kernel_engine(
+				m_residues, 0, kernels::sidechain_distance_kernel<T>())
+				.slice(0);
 		}
 
 		arma::Mat<T> compute_neighbours(T threshold) const noexcept
 		{
-			auto neighbour_kernel = [threshold](const std::shared_ptr<Residue<T>>& residue,
-										const std::shared_ptr<Residue<T>>& residue_neighbour) {
-				auto sidechain = residue->get_sidechain_atoms();
-				auto sidechain_neighbour = residue_neighbour->get_sidechain_atoms();
-				T found_neighbour = 0;
-
-				for (arma::uword i = 0; i < sidechain.n_cols; ++i)
-				{
-					for (arma::uword j = i + 1; j < sidechain_neighbour.n_cols; ++j)
-					{
-						auto dist = kernels::distance_lazy<T>(
-							sidechain.col(i), sidechain_neighbour.col(j));
-						if (dist < threshold)
-							return 1;
-					}
-				}
-				return 0;
-			};
-			return core::pairwise_residue_kernel_engine(m_residues, 0, neighbour_kernel).slice(0);
+			return core::pairwise_residue_kernel_engine(
+				m_residues, 0, kernels::sidechain_contact_kernel<T>(threshold))
+				.slice(0);
 		}
 
-		//    void rotate(arma::Col<T> &rotation); // rotation = [rotation_x,
-		//    rotation_y, rotation_z] void rotate(T rotation_angle, std::string
-		//    axis);
-		//    // axis = {"x", "y", "z"}
-		void append_new_residue(const std::pair<const std::string, atomVector<T>>& atom_pair,
-			residueVector<T>& residues, bool n_terminus, bool c_terminus)
+		/**
+		 * The sidechain contacts of compute_neighbours as a 2 x n_contacts
+		 * matrix of residue pairs (i, j), with i < j. Only the pairs of residues
+		 * that are close enough to be in contact are compared, so this scales to
+		 * structures where the n_residues x n_residues matrix does not fit.
+		 */
+		arma::Mat<T> compute_neighbour_pairs(T threshold) const noexcept
 		{
-			residues.emplace_back(std::make_shared<Residue<T>>(atom_pair.second,
-				atom_pair.first.substr(0, 3), atom_pair.first, n_terminus, c_terminus));
-			m_xyz.insert_cols(static_cast<arma::uword>(m_natoms), residues.back()->get_xyz());
-			m_radii.insert_rows(static_cast<arma::uword>(m_natoms), residues.back()->getRadii());
-			m_natoms += residues.back()->n_atoms();
+			const auto contacts = core::sparse_pairwise_residue_kernel_engine(
+				m_residues, threshold, kernels::sidechain_contact_kernel<T>(threshold));
+			std::vector<T> coo;
+
+			for (arma::uword pair = 0; pair < contacts.pairs.n_cols; ++pair)
+			{
+				if (contacts.values.at(0, pair) == 0)
+					continue;
+				coo.insert(coo.end(),
+					{ static_cast<T>(contacts.pairs.at(0, pair)),
+						static_cast<T>(contacts.pairs.at(1, pair)) });
+			}
+			return arma::Mat<T>(coo.data(), 2, coo.size() / 2);
 		}
 
-		void append_new_residue(const Residue<T>& residue, bool n_terminus, bool c_terminus)
+		/**
+		 * The shortest sidechain distances of compute_shortest_distance that are
+		 * shorter than cutoff, as a 3 x n matrix of (i, j, distance), with i < j.
+		 */
+		arma::Mat<T> compute_shortest_distance_pairs(T cutoff) const noexcept
 		{
-			m_xyz.insert_cols(static_cast<arma::uword>(m_natoms), residue.get_xyz());
-			m_radii.insert_rows(static_cast<arma::uword>(m_natoms), residue.getRadii());
-			m_natoms += residue.n_atoms();
+			const auto distances = core::sparse_pairwise_residue_kernel_engine(
+				m_residues, cutoff, kernels::sidechain_distance_kernel<T>());
+			std::vector<T> coo;
+
+			for (arma::uword pair = 0; pair < distances.pairs.n_cols; ++pair)
+			{
+				const T distance = distances.values.at(0, pair);
+				if (!(distance < cutoff))
+					continue;
+				coo.insert(coo.end(),
+					{ static_cast<T>(distances.pairs.at(0, pair)),
+						static_cast<T>(distances.pairs.at(1, pair)), distance });
+			}
+			return arma::Mat<T>(coo.data(), 3, coo.size() / 3);
 		}
 
+		//    void rotate(arma::Col<T> &rotation); // rotation = [rotation_x,
+		//    rotation_y, rotation_z] void rotate(T rotation_angle, std::string
+		//    axis);
+		//    // axis = {"x", "y", "z"}
+
 		arma::Mat<T> get_backbone_atoms() const noexcept
 		{
 			arma::Mat<T> result(3, m_nresidues * 4);
@@ -274,12 +518,144 @@ namespace prostruct
 		}
 
 	protected:
+		/** Whether each residue is the first residue of a chain */
+		std::vector<bool> chain_starts() const
+		{
+			std::vector<bool> result;
+			result.reserve(m_residues.size());
+			for (const auto& residue : m_residues)
+				result.push_back(residue->is_n_terminus());
+			return result;
+		}
+
+		/**
+		 * Whether each residue has a backbone N-H that can form a hydrogen bond,
+		 * which is not the case for N-terminal residues and prolines.
+		 */
+		std::vector<bool> donor_residues() const
+		{
+			std::vector<bool> result;
+			result.reserve(m_residues.size());
+			for (const auto& residue : m_residues)
+			{
+				result.push_back(!residue->is_n_terminus()
+					&& residue->get_amino_acid_type() != AminoAcid::PRO);
+			}
+			if (!result.empty())
+				result.front() = false;
+			return result;
+		}
+
+		arma::Col<T> sum_residue_sasa(const arma::Col<T>& asa) const noexcept
+		{
+			arma::Col<T> result(m_nresidues);
+			arma::uword pos = 0;
+			arma::uword i = 0;
+
+			for (auto const& residue : m_residues)
+			{
+				const auto n_atoms = static_cast<arma::uword>(residue->n_atoms());
+				result.at(i++) = arma::accu(asa.subvec(pos, pos + n_atoms - 1));
+				pos += n_atoms;
+			}
+			return result;
+		}
+
+		std::shared_ptr<AtomTable<T>> m_atom_table;
+		arma::uword m_first_atom = 0;
 		arma::Mat<T> m_xyz;
 		int m_natoms;
 		arma::uword m_nresidues;
 		arma::Col<T> m_radii;
 		residueVector<T> m_residues;
 		static constexpr T to_rad_constant = 180.0 / M_PI;
+
+#ifndef SWIG
+		/** The columns of the backbone of each residue, see backbone_layout */
+		struct BackboneLayout
+		{
+			std::vector<arma::uword> first_atoms; /**< the column of N, then CA, C and O */
+			std::vector<bool> chain_start;
+		};
+
+		/**
+		 * The residues do not change after construction, so their layout is
+		 * found once, on first use, and shared by copies (whose residues have the
+		 * same layout). Concurrent first calls may both build it, with the same
+		 * result.
+		 */
+		std::shared_ptr<const BackboneLayout> backbone_layout() const
+		{
+			auto layout = std::atomic_load(&m_backbone_layout);
+			if (layout && layout->first_atoms.size() == m_residues.size())
+				return layout;
+
+			auto result = std::make_shared<BackboneLayout>();
+			result->first_atoms.reserve(m_residues.size());
+			arma::uword position = 0;
+			for (const auto& residue : m_residues)
+			{
+				result->first_atoms.push_back(position);
+				position += residue->n_atoms();
+			}
+			result->chain_start = chain_starts();
+			layout = std::move(result);
+			std::atomic_store(&m_backbone_layout, layout);
+			return layout;
+		}
+
+		mutable std::shared_ptr<const BackboneLayout> m_backbone_layout;
+
+		/** The coordinates of other, as a view into table if other has a table */
+		static arma::Mat<T> table_xyz(
+			const std::shared_ptr<AtomTable<T>>& table, const StructBase& other)
+		{
+			if (table)
+				return table->xyz_view(
+					other.m_first_atom, static_cast<arma::uword>(other.m_natoms));
+			return other.m_xyz;
+		}
+
+		static arma::Col<T> table_radii(
+			const std::shared_ptr<AtomTable<T>>& table, const StructBase& other)
+		{
+			if (table)
+				return table->radii_view(
+					other.m_first_atom, static_cast<arma::uword>(other.m_natoms));
+			return other.m_radii;
+		}
+
+		/** The residues of other, moved to table (a copy of the table of other) */
+		static residueVector<T> copy_residues(
+			const std::shared_ptr<AtomTable<T>>& table, const StructBase& other)
+		{
+			residueVector<T> result;
+			result.reserve(other.m_residues.size());
+			for (const auto& residue : other.m_residues)
+			{
+				if (table && residue->get_atom_table() == other.m_atom_table)
+					result.emplace_back(std::make_shared<Residue<T>>(*residue, table));
+				else
+					result.emplace_back(residue);
+			}
+			return result;
+		}
+
+		/** The coordinates of each structure as a slice, see geometry::rmsd_matrix */
+		template <typename Structure>
+		static arma::Cube<T> stack_frames(const std::vector<std::shared_ptr<Structure>>& structures)
+		{
+			const arma::uword n_atoms = structures.empty() ? 0 : structures.front()->n_atoms();
+			arma::Cube<T> frames(3, n_atoms, structures.size());
+			for (arma::uword i = 0; i < structures.size(); ++i)
+			{
+				if (static_cast<arma::uword>(structures[i]->n_atoms()) != n_atoms)
+					throw "Atom number mismatch";
+				frames.slice(i) = structures[i]->xyz_ref();
+			}
+			return frames;
+		}
+#endif
 		void internalKS(arma::Mat<T>& E) const noexcept
 		{
 			auto backbone_atom_coords = get_backbone_atoms();
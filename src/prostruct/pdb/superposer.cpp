@@ -0,0 +1,176 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "prostruct/pdb/superposer.h"
+#include "prostruct/pdb/geometry.h"
+#include "prostruct/pdb/qcp.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace prostruct::geometry
+{
+	namespace
+	{
+		arma::uword required_atoms(const arma::Col<arma::uword>& fit_indices,
+			const arma::Col<arma::uword>& score_indices)
+		{
+			if (fit_indices.n_elem == 0)
+				throw "Expected at least one atom to superpose";
+
+			arma::uword result = fit_indices.max() + 1;
+			if (score_indices.n_elem > 0)
+				result = std::max(result, score_indices.max() + 1);
+			return result;
+		}
+
+		/** Copies the columns of xyz at indices into the preallocated result */
+		template <typename T>
+		void gather(const arma::Mat<T>& xyz, const arma::Col<arma::uword>& indices,
+			arma::Mat<T>& result) noexcept
+		{
+			for (arma::uword i = 0; i < indices.n_elem; ++i)
+			{
+				const T* source = xyz.colptr(indices[i]);
+				T* target = result.colptr(i);
+				target[0] = source[0];
+				target[1] = source[1];
+				target[2] = source[2];
+			}
+		}
+	}
+
+	template <typename T>
+	Superposer<T>::Superposer(const arma::Mat<T>& reference,
+		arma::Col<arma::uword> fit_indices, arma::Col<arma::uword> score_indices)
+		: m_fit_indices(std::move(fit_indices))
+		, m_score_indices(std::move(score_indices))
+		, m_same_selection(m_fit_indices.n_elem == m_score_indices.n_elem
+			  && std::equal(
+				  m_fit_indices.cbegin(), m_fit_indices.cend(), m_score_indices.cbegin()))
+		, m_required_atoms(required_atoms(m_fit_indices, m_score_indices))
+		, m_reference_fit(3, m_fit_indices.n_elem)
+		, m_reference_centroid(3)
+		, m_reference_score(3, m_score_indices.n_elem)
+		, m_fit_buffer(3, m_fit_indices.n_elem)
+		, m_centroid(3)
+		, m_rotation(arma::eye<arma::Mat<T>>(3, 3))
+		, m_fit_rmsd(0)
+	{
+		set_reference(reference);
+	}
+
+	template <typename T>
+	Superposer<T>::Superposer(const arma::Mat<T>& reference, arma::Col<arma::uword> indices)
+		: Superposer(reference, indices, indices)
+	{
+	}
+
+	template <typename T>
+	void Superposer<T>::set_reference(const arma::Mat<T>& reference)
+	{
+		check_size(reference);
+
+		gather(reference, m_fit_indices, m_reference_fit);
+		get_centroid(m_reference_fit, m_reference_centroid);
+		m_reference_fit.each_col() -= m_reference_centroid;
+		m_reference_self_inner_product = qcp_self_inner_product(m_reference_fit);
+
+		gather(reference, m_score_indices, m_reference_score);
+	}
+
+	template <typename T>
+	T Superposer<T>::rmsd(const arma::Mat<T>& xyz)
+	{
+		check_size(xyz);
+		fit(xyz, !m_same_selection);
+		return m_same_selection ? m_fit_rmsd : score(xyz, true);
+	}
+
+	template <typename T>
+	T Superposer<T>::superpose(arma::Mat<T>& xyz)
+	{
+		check_size(xyz);
+		fit(xyz, true);
+
+		const T cx = m_centroid[0], cy = m_centroid[1], cz = m_centroid[2];
+		const T rx = m_reference_centroid[0], ry = m_reference_centroid[1],
+				rz = m_reference_centroid[2];
+		const arma::Mat<T>& R = m_rotation;
+
+		for (arma::uword i = 0; i < xyz.n_cols; ++i)
+		{
+			T* atom = xyz.colptr(i);
+			const T x = atom[0] - cx, y = atom[1] - cy, z = atom[2] - cz;
+			atom[0] = R.at(0, 0) * x + R.at(0, 1) * y + R.at(0, 2) * z + rx;
+			atom[1] = R.at(1, 0) * x + R.at(1, 1) * y + R.at(1, 2) * z + ry;
+			atom[2] = R.at(2, 0) * x + R.at(2, 1) * y + R.at(2, 2) * z + rz;
+		}
+
+		return m_same_selection ? m_fit_rmsd : score(xyz, false);
+	}
+
+	template <typename T>
+	void Superposer<T>::check_size(const arma::Mat<T>& xyz) const
+	{
+		if (xyz.n_rows != 3 || xyz.n_cols < m_required_atoms)
+			throw "Atom number mismatch";
+	}
+
+	template <typename T>
+	void Superposer<T>::fit(const arma::Mat<T>& xyz, bool with_rotation)
+	{
+		gather(xyz, m_fit_indices, m_fit_buffer);
+		get_centroid(m_fit_buffer, m_centroid);
+		m_fit_buffer.each_col() -= m_centroid;
+
+		const auto inner_product = qcp_inner_product(m_fit_buffer, m_reference_fit,
+			qcp_self_inner_product(m_fit_buffer), m_reference_self_inner_product);
+
+		m_fit_rmsd = static_cast<T>(qcp_rmsd(inner_product));
+		if (with_rotation)
+			m_rotation = qcp_rotation<T>(inner_product);
+	}
+
+	template <typename T>
+	T Superposer<T>::score(const arma::Mat<T>& xyz, bool apply_fit) const
+	{
+		if (m_score_indices.n_elem == 0)
+			return 0;
+
+		const arma::Mat<T>& R = m_rotation;
+		double sum = 0;
+		for (arma::uword i = 0; i < m_score_indices.n_elem; ++i)
+		{
+			const T* atom = xyz.colptr(m_score_indices[i]);
+			const T* reference = m_reference_score.colptr(i);
+
+			T x = atom[0], y = atom[1], z = atom[2];
+			if (apply_fit)
+			{
+				x -= m_centroid[0];
+				y -= m_centroid[1];
+				z -= m_centroid[2];
+				const T x_r = R.at(0, 0) * x + R.at(0, 1) * y + R.at(0, 2) * z;
+				const T y_r = R.at(1, 0) * x + R.at(1, 1) * y + R.at(1, 2) * z;
+				const T z_r = R.at(2, 0) * x + R.at(2, 1) * y + R.at(2, 2) * z;
+				x = x_r + m_reference_centroid[0];
+				y = y_r + m_reference_centroid[1];
+				z = z_r + m_reference_centroid[2];
+			}
+
+			const double dx = x - reference[0], dy = y - reference[1], dz = z - reference[2];
+			sum += dx * dx + dy * dy + dz * dz;
+		}
+
+		return static_cast<T>(std::sqrt(sum / m_score_indices.n_elem));
+	}
+
+	template class Superposer<float>;
+	template class Superposer<double>;
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_SUPERPOSER_H
+#define PROSTRUCT_SUPERPOSER_H
+
+#include <armadillo>
+
+namespace prostruct::geometry
+{
+	/**
+	 * Superposes structures onto a reference using one selection of atoms
+	 * (e.g. CA or backbone atoms) and scores them with the RMSD over another
+	 * (e.g. all heavy atoms or a binding site). The selections and the reference
+	 * are gathered once, and the coordinates of each compared structure are
+	 * gathered into buffers that are reused, so comparing the frames of a
+	 * trajectory or ensemble does not allocate.
+	 * A Superposer is not thread safe, use one per thread.
+	 */
+	template <typename T>
+	class Superposer
+	{
+	public:
+		/**
+		 * fit_indices and score_indices are atom (column) indices into the
+		 * coordinates of the reference and of the compared structures.
+		 */
+		Superposer(const arma::Mat<T>& reference, arma::Col<arma::uword> fit_indices,
+			arma::Col<arma::uword> score_indices);
+
+		/** Fits and scores on the same atoms */
+		Superposer(const arma::Mat<T>& reference, arma::Col<arma::uword> indices);
+
+		/** Replaces the reference, keeping the selections */
+		void set_reference(const arma::Mat<T>& reference);
+
+		/**
+		 * The RMSD over the score atoms of xyz and the reference, after the
+		 * superposition of the fit atoms of xyz onto those of the reference.
+		 */
+		T rmsd(const arma::Mat<T>& xyz);
+
+		/**
+		 * Moves xyz (all its atoms) by the superposition of its fit atoms onto
+		 * those of the reference, and returns the RMSD over the score atoms.
+		 */
+		T superpose(arma::Mat<T>& xyz);
+
+		arma::uword n_fit_atoms() const noexcept { return m_fit_indices.n_elem; }
+
+		arma::uword n_score_atoms() const noexcept { return m_score_indices.n_elem; }
+
+	private:
+		/** Throws if xyz does not have the selected atoms */
+		void check_size(const arma::Mat<T>& xyz) const;
+
+		/**
+		 * Finds the centroid, RMSD and (if with_rotation) rotation of the
+		 * superposition of the fit atoms of xyz onto the reference
+		 */
+		void fit(const arma::Mat<T>& xyz, bool with_rotation);
+
+		/** The RMSD of the score atoms of xyz, moved by the last fit if apply_fit */
+		T score(const arma::Mat<T>& xyz, bool apply_fit) const;
+
+		arma::Col<arma::uword> m_fit_indices;
+		arma::Col<arma::uword> m_score_indices;
+		bool m_same_selection;
+		arma::uword m_required_atoms;
+
+		arma::Mat<T> m_reference_fit; /**< centred */
+		arma::Col<T> m_reference_centroid;
+		double m_reference_self_inner_product;
+		arma::Mat<T> m_reference_score;
+
+		// per comparison state
+		arma::Mat<T> m_fit_buffer;
+		arma::Col<T> m_centroid;
+		arma::Mat<T> m_rotation;
+		T m_fit_rmsd;
+	};
+}
+
+#endif // PROSTRUCT_SUPERPOSER_H
@@ -0,0 +1,95 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include <prostruct/pdb/trajectory.h>
+
+#include <algorithm>
+
+using namespace prostruct;
+
+template <typename T>
+Trajectory<T>::Trajectory(
+	std::shared_ptr<PDB<T>> topology, const std::string& filename, size_t n_buffers)
+	: m_topology(std::move(topology))
+	, m_reader(parsers::open_trajectory(filename))
+	, m_buffers(std::max<size_t>(n_buffers, 1))
+	, m_free_buffers(m_buffers.size())
+	, m_ready_buffers(m_buffers.size())
+{
+	if (!m_topology)
+		throw "Expected a topology";
+	if (m_reader->n_atoms() != m_topology->get_table_positions().size())
+		throw "Atom number mismatch";
+
+	for (size_t i = 0; i < m_buffers.size(); ++i)
+	{
+		m_buffers[i].resize(3 * m_reader->n_atoms());
+		m_free_buffers.push(i);
+	}
+
+	if (n_buffers > 0)
+		m_producer = std::thread(&Trajectory::produce, this);
+}
+
+template <typename T>
+Trajectory<T>::~Trajectory()
+{
+	m_free_buffers.close();
+	m_ready_buffers.close();
+	if (m_producer.joinable())
+		m_producer.join();
+}
+
+template <typename T>
+bool Trajectory<T>::next()
+{
+	if (!m_producer.joinable())
+	{
+		if (!m_reader->read_frame(m_buffers[0].data()))
+			return false;
+		m_topology->set_file_order_xyz(m_buffers[0].data());
+		++m_n_frames;
+		return true;
+	}
+
+	const auto buffer = m_ready_buffers.pop();
+	if (!buffer)
+	{
+		// the producer stops at the end of the file or at its first error
+		if (m_error)
+			std::rethrow_exception(m_error);
+		return false;
+	}
+
+	m_topology->set_file_order_xyz(m_buffers[*buffer].data());
+	m_free_buffers.push(*buffer);
+	++m_n_frames;
+	return true;
+}
+
+template <typename T>
+void Trajectory<T>::produce()
+{
+	try
+	{
+		while (const auto buffer = m_free_buffers.pop())
+		{
+			if (!m_reader->read_frame(m_buffers[*buffer].data())
+				|| !m_ready_buffers.push(*buffer))
+				break;
+		}
+	}
+	catch (...)
+	{
+		m_error = std::current_exception();
+	}
+	m_ready_buffers.close();
+}
+
+template class prostruct::Trajectory<float>;
+template class prostruct::Trajectory<double>;
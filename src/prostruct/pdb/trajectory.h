@@ -0,0 +1,93 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_TRAJECTORY_H
+#define PROSTRUCT_TRAJECTORY_H
+
+#include <prostruct/pdb/PDB.h>
+
+#ifndef SWIG
+#include <prostruct/parsers/trajectory_reader.h>
+#include <prostruct/utils/bounded_queue.h>
+
+#include <exception>
+#include <thread>
+#endif
+
+namespace prostruct
+{
+	/**
+	 * The frames of a DCD or XTC trajectory, loaded one at a time into the
+	 * coordinates of a PDB topology (whose atoms are in the order of the
+	 * trajectory), so that any analysis of the PDB (e.g. calculate_phi_psi,
+	 * compute_shrake_rupley or kabsch_rmsd) can be run for each frame, using
+	 * the memory of n_buffers frames however long the trajectory is.
+	 * The frames are decoded ahead by a background thread into a ring of
+	 * n_buffers buffers, or in the calling thread if n_buffers is 0.
+	 * The Trajectory shares ownership of the topology, so the topology stays
+	 * alive while frames are loaded into it (e.g. from Python).
+	 */
+	template <typename T>
+	class Trajectory
+	{
+	public:
+		Trajectory(std::shared_ptr<PDB<T>> topology, const std::string& filename,
+			size_t n_buffers = 2);
+
+		~Trajectory();
+
+		Trajectory(const Trajectory&) = delete;
+		Trajectory& operator=(const Trajectory&) = delete;
+
+		/**
+		 * Loads the next frame into the topology, overwriting its coordinates.
+		 * Returns false after the last frame.
+		 */
+		bool next();
+
+		/**
+		 * The index of the frame loaded by the last call to next. Throws if next
+		 * has not loaded a frame yet.
+		 */
+		arma::uword frame() const
+		{
+			if (m_n_frames == 0)
+				throw "No frame loaded, call next first";
+			return m_n_frames - 1;
+		}
+
+		arma::uword n_atoms() const noexcept { return m_reader->n_atoms(); }
+
+#ifndef SWIG
+		/** Calls f(frame_index) with each frame in turn loaded into the topology */
+		template <typename F>
+		void for_each_frame(F&& f)
+		{
+			while (next())
+				f(frame());
+		}
+#endif
+
+	private:
+#ifndef SWIG
+		/** The background thread: decodes frames into the free buffers */
+		void produce();
+
+		std::shared_ptr<PDB<T>> m_topology;
+		std::unique_ptr<parsers::TrajectoryReader> m_reader;
+		std::vector<std::vector<float>> m_buffers;
+		BoundedQueue<size_t> m_free_buffers;
+		BoundedQueue<size_t> m_ready_buffers;
+		std::exception_ptr m_error;
+		std::thread m_producer;
+		arma::uword m_n_frames = 0;
+#endif
+	};
+}
+
+#endif // PROSTRUCT_TRAJECTORY_H
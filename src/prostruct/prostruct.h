@@ -10,6 +10,10 @@
 #define PROSTRUCT_PROSTRUCT_H
 
 #include <prostruct/pdb/PDB.h>
+#include <prostruct/pdb/ensemble.h>
+#include <prostruct/pdb/loader.h>
+#include <prostruct/pdb/superposer.h>
+#include <prostruct/pdb/trajectory.h>
 #ifdef SWIGPYTHON
 #include <prostruct/pdb/custom_pdb.h>
 #endif
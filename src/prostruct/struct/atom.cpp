@@ -10,6 +10,7 @@
 #include "atom.h"
 
 #include <algorithm>
+#include <cctype>
 #include <memory>
 
 using namespace prostruct;
@@ -259,6 +260,49 @@ static const std::map<std::string, std::vector<double>> elementDescription {
 	{ "Uo", { 118, 294 } }
 };
 
+std::uint8_t prostruct::element_code(std::string_view symbol)
+{
+	// element symbols have at most two letters, so all of them fit in a 16 bit
+	// lookup table indexed by the upper case letters, e.g. FE and Fe -> 26
+	auto key = [](std::string_view element) -> size_t {
+		if (element.empty() || element.size() > 2)
+			return 0;
+		size_t result = static_cast<size_t>(std::toupper(static_cast<unsigned char>(element[0])))
+			<< 8;
+		if (element.size() == 2)
+			result |= static_cast<size_t>(std::toupper(static_cast<unsigned char>(element[1])));
+		return result;
+	};
+
+	static const std::vector<std::uint8_t> codes = [&key]() {
+		std::vector<std::uint8_t> result(1 << 16, 0);
+		for (const auto& [element, description] : elementDescription)
+			result[key(element)] = static_cast<std::uint8_t>(description[0]);
+		return result;
+	}();
+
+	auto code = codes[key(symbol)];
+	if (code == 0)
+		throw "Unknown element: " + std::string(symbol);
+
+	return code;
+}
+
+std::string prostruct::element_symbol(std::uint8_t code)
+{
+	static const std::vector<std::string> symbols = []() {
+		std::vector<std::string> result(elementDescription.size() + 1);
+		for (const auto& [symbol, description] : elementDescription)
+			result[static_cast<size_t>(description[0])] = symbol;
+		return result;
+	}();
+
+	if (code == 0 || code >= symbols.size())
+		throw "Unknown atomic number: " + std::to_string(code);
+
+	return symbols[code];
+}
+
 template <typename T>
 void Atom<T>::load_atom(const std::string& element_)
 {
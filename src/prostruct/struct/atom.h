@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 
+#include <prostruct/struct/atom_table.h>
 #include <prostruct/struct/bond.h>
 #include <armadillo>
 
@@ -31,6 +32,17 @@ namespace prostruct {
 			load_atom(element, name, x, y, z);
 		};
 
+		/**
+		 * A view of atom index in an AtomTable. The coordinates and radius are
+		 * read from (and written to) the table, so the view always reflects the
+		 * current state of the structure.
+		 */
+		Atom(std::shared_ptr<AtomTable<T>> table, arma::uword index)
+			: m_table(std::move(table)), m_index(index) {
+			load_atom(element_symbol(m_table->element(m_index)),
+					  unpack_atom_name(m_table->name(m_index)));
+		}
+
 		std::shared_ptr<Atom<T>> getAtom() { return this->shared_from_this(); };
 
 		void addBond(std::shared_ptr<Atom<T>> atom, int bondType);
@@ -41,7 +53,12 @@ namespace prostruct {
 
 		void destroyBond(std::shared_ptr<Bond<T>>);
 
-		void setRadius(double radius_) { radius = radius_; }
+		void setRadius(double radius_) {
+			if (m_table)
+				m_table->radii().at(m_index) = radius_;
+			else
+				radius = radius_;
+		}
 
 		std::vector<std::shared_ptr<Bond<T>>> getBonds() { return bonds; };
 
@@ -53,17 +70,17 @@ namespace prostruct {
 
 		int getAtomicNumber() { return atomicNumber; }
 
-		T getX() { return x; }
+		T getX() { return m_table ? m_table->xyz().at(0, m_index) : x; }
 
-		T getY() { return y; }
+		T getY() { return m_table ? m_table->xyz().at(1, m_index) : y; }
 
-		T getZ() { return z; }
+		T getZ() { return m_table ? m_table->xyz().at(2, m_index) : z; }
 
-		T getRadius() { return radius; }
+		T getRadius() { return m_table ? m_table->radii().at(m_index) : radius; }
 
 		std::string getElement() { return name; }
 
-		arma::Col<T> getXYZ() { return arma::Col<T>(std::vector<T>({x, y, z})); }
+		arma::Col<T> getXYZ() { return arma::Col<T>(std::vector<T>({getX(), getY(), getZ()})); }
 
 		std::string get_name() const noexcept { return name; }
 
@@ -82,6 +99,8 @@ namespace prostruct {
 		std::string element;
 		std::string name;
 		std::vector<std::shared_ptr<Bond<T>>> bonds;
+		std::shared_ptr<AtomTable<T>> m_table; /**< set when this atom is a view into a table */
+		arma::uword m_index = 0;
 	};
 }
 
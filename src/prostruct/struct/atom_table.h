@@ -0,0 +1,143 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_ATOM_TABLE_H
+#define PROSTRUCT_ATOM_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <armadillo>
+
+namespace prostruct
+{
+	/**
+	 * PDB atom names are at most four characters long, so they are stored
+	 * as the four characters packed into an integer, e.g. "CA" -> 'C' | 'A' << 8.
+	 * Comparing two names is then a single integer comparison.
+	 */
+	using atom_name_t = std::uint32_t;
+
+	constexpr atom_name_t pack_atom_name(std::string_view name) noexcept
+	{
+		atom_name_t result = 0;
+		for (size_t i = 0; i < name.size() && i < 4; ++i)
+			result |= static_cast<atom_name_t>(static_cast<unsigned char>(name[i])) << (8 * i);
+		return result;
+	}
+
+	inline std::string unpack_atom_name(atom_name_t name)
+	{
+		std::string result;
+		for (; name != 0; name >>= 8)
+			result.push_back(static_cast<char>(name & 0xFF));
+		return result;
+	}
+
+	/**
+	 * Returns the atomic number of an element symbol. PDB files write the element
+	 * symbol in upper case (e.g. FE), so the lookup is case insensitive.
+	 * Throws if the element is unknown.
+	 */
+	std::uint8_t element_code(std::string_view symbol);
+
+	/**
+	 * Returns the element symbol of an atomic number, e.g. 26 -> Fe
+	 */
+	std::string element_symbol(std::uint8_t code);
+
+	/**
+	 * Contiguous structure-of-arrays storage for all the atoms of a structure.
+	 * Column i of xyz, row i of radii and element i of every other array
+	 * describe atom i. Residues and chains refer to a [first, first + n) range
+	 * of atoms in the table.
+	 *
+	 * @tparam T the floating point type of coordinates and radii
+	 */
+	template <typename T>
+	class AtomTable
+	{
+	public:
+		AtomTable() = default;
+
+		explicit AtomTable(arma::uword n_atoms) { resize(n_atoms); }
+
+		void resize(arma::uword n_atoms)
+		{
+			m_xyz.set_size(3, n_atoms);
+			m_radii.set_size(n_atoms);
+			m_elements.resize(n_atoms);
+			m_names.resize(n_atoms);
+			m_residue_indices.resize(n_atoms);
+		}
+
+		arma::uword n_atoms() const noexcept { return m_xyz.n_cols; }
+
+		void set_atom(arma::uword index, std::uint8_t element, atom_name_t name, T x, T y, T z,
+			arma::uword residue_index) noexcept
+		{
+			m_xyz.at(0, index) = x;
+			m_xyz.at(1, index) = y;
+			m_xyz.at(2, index) = z;
+			m_elements[index] = element;
+			m_names[index] = name;
+			m_residue_indices[index] = residue_index;
+		}
+
+		arma::Mat<T>& xyz() noexcept { return m_xyz; }
+		const arma::Mat<T>& xyz() const noexcept { return m_xyz; }
+
+		arma::Col<T>& radii() noexcept { return m_radii; }
+		const arma::Col<T>& radii() const noexcept { return m_radii; }
+
+		/**
+		 * A matrix that shares the memory of the coordinates of the atoms
+		 * [first_atom, first_atom + n_atoms). It is only valid while the table
+		 * is alive and not resized, and cannot itself be resized.
+		 */
+		arma::Mat<T> xyz_view(arma::uword first_atom, arma::uword n_atoms) noexcept
+		{
+			return arma::Mat<T>(m_xyz.memptr() + 3 * first_atom, 3, n_atoms, false, true);
+		}
+
+		/** Same as xyz_view, for the radii */
+		arma::Col<T> radii_view(arma::uword first_atom, arma::uword n_atoms) noexcept
+		{
+			return arma::Col<T>(m_radii.memptr() + first_atom, n_atoms, false, true);
+		}
+
+		std::uint8_t element(arma::uword index) const noexcept { return m_elements[index]; }
+
+		atom_name_t name(arma::uword index) const noexcept { return m_names[index]; }
+
+		arma::uword residue_index(arma::uword index) const noexcept
+		{
+			return m_residue_indices[index];
+		}
+
+		const std::vector<std::uint8_t>& elements() const noexcept { return m_elements; }
+
+		const std::vector<atom_name_t>& names() const noexcept { return m_names; }
+
+		const std::vector<arma::uword>& residue_indices() const noexcept
+		{
+			return m_residue_indices;
+		}
+
+	private:
+		arma::Mat<T> m_xyz; /**< 3 x n_atoms coordinates */
+		arma::Col<T> m_radii; /**< atomic radii */
+		std::vector<std::uint8_t> m_elements; /**< atomic numbers */
+		std::vector<atom_name_t> m_names; /**< packed atom names */
+		std::vector<arma::uword> m_residue_indices; /**< index of the residue of each atom */
+	};
+}
+
+#endif // PROSTRUCT_ATOM_TABLE_H
@@ -71,5 +71,47 @@ Chain<T>::Chain(const std::vector<std::shared_ptr<Residue<T>>>& residues,
 	this->m_nresidues = static_cast<int>(residues.size());
 }
 
+template <typename T>
+Chain<T>::Chain(const std::vector<std::shared_ptr<Residue<T>>>& residues,
+	const std::string& chainName, std::shared_ptr<AtomTable<T>> table, arma::uword first_atom,
+	arma::uword n_atoms)
+	: StructBase<T>(std::move(table), first_atom, n_atoms)
+	, m_chain_name(chainName)
+{
+	this->m_residues = residues;
+	this->m_nresidues = static_cast<int>(residues.size());
+	link_table_residues();
+}
+
+template <typename T>
+Chain<T>::Chain(const Chain& other)
+	: StructBase<T>(other)
+	, m_chain_name(other.m_chain_name)
+{
+	link_table_residues();
+}
+
+template <typename T>
+Chain<T>& Chain<T>::operator=(const Chain& other)
+{
+	if (this == &other)
+		return *this;
+	StructBase<T>::operator=(other);
+	m_chain_name = other.m_chain_name;
+	link_table_residues();
+	return *this;
+}
+
+template <typename T>
+void Chain<T>::link_table_residues()
+{
+	// the residues are views into the table, so their Atom objects (and the
+	// peptide bonds between them) are only created when they are used
+	if (!this->m_atom_table)
+		return;
+	for (size_t i = 1; i < this->m_residues.size(); ++i)
+		Residue<T>::link_table_views(this->m_residues[i - 1], this->m_residues[i]);
+}
+
 template class prostruct::Chain<float>;
 template class prostruct::Chain<double>;
\ No newline at end of file
@@ -31,6 +31,19 @@ namespace prostruct
 		Chain(const std::vector<std::shared_ptr<Residue<T>>>&, const std::string&);
 		Chain(const std::vector<std::shared_ptr<Residue<T>>>&, const std::string&,
 			const arma::Mat<T>& xyz);
+#ifndef SWIG
+		/**
+		 * A chain made of the atoms [first_atom, first_atom + n_atoms) of
+		 * table, which must be the atoms of residues.
+		 */
+		Chain(const std::vector<std::shared_ptr<Residue<T>>>&, const std::string&,
+			std::shared_ptr<AtomTable<T>> table, arma::uword first_atom, arma::uword n_atoms);
+
+		/** A copy with its own AtomTable, see StructBase */
+		Chain(const Chain& other);
+
+		Chain& operator=(const Chain& other);
+#endif
 
 		virtual std::string to_string() const noexcept final
 		{
@@ -63,6 +76,9 @@ namespace prostruct
 		}
 #endif
 	private:
+		/** Links the residues that are views into the table, see Residue::link_table_views */
+		void link_table_residues();
+
 		std::string m_chain_name;
 	};
 }
@@ -7,3 +7,15 @@
  */
 
 #include "prostruct/struct/model.h"
+
+using namespace prostruct;
+
+template <typename T>
+Model<T>::Model(arma::Cube<T>& models, arma::uword index)
+	: xyz(models.slice_memptr(index), models.n_rows, models.n_cols, false, true)
+	, m_index(index)
+{
+}
+
+template class prostruct::Model<float>;
+template class prostruct::Model<double>;
@@ -9,12 +9,31 @@
 #ifndef PROSTRUCT_MODEL_H
 #define PROSTRUCT_MODEL_H
 
-
-class model {
-
-
-
-};
-
-
-#endif //PROSTRUCT_MODEL_H
+#include <armadillo>
+
+namespace prostruct
+{
+	/**
+	 * One model (MODEL/ENDMDL block) of an Ensemble: its index and a view of
+	 * its coordinates, which are owned by the Ensemble. The atoms are in the
+	 * order of the topology shared by all the models, so the columns of xyz
+	 * match the atoms of the Ensemble.
+	 */
+	template <typename T>
+	class Model
+	{
+	public:
+		Model(arma::Cube<T>& models, arma::uword index);
+
+		arma::uword index() const noexcept { return m_index; }
+
+		arma::uword n_atoms() const noexcept { return xyz.n_cols; }
+
+		arma::Mat<T> xyz; /**< view into the coordinates of the Ensemble */
+
+	private:
+		arma::uword m_index;
+	};
+}
+
+#endif // PROSTRUCT_MODEL_H
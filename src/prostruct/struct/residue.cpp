@@ -9,6 +9,8 @@
 #include <prostruct/struct/residue.h>
 #include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <tuple>
 
 using namespace prostruct;
 
@@ -489,6 +491,134 @@ const static stringIndexMap aminoAcidIndex {
 	{ "VAL", 19 }
 };
 
+// the four atoms that define each chi angle (0 for chi1, ..., 4 for chi5)
+const static std::vector<std::tuple<AminoAcid, int, std::array<const char*, 4>>> chiAtoms {
+	{ AminoAcid::ARG, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::ARG, 1, { "CA", "CB", "CG", "CD" } },
+	{ AminoAcid::ARG, 2, { "CB", "CG", "CD", "NE" } },
+	{ AminoAcid::ARG, 3, { "CG", "CD", "NE", "CZ" } },
+	{ AminoAcid::ARG, 4, { "CD", "NE", "CZ", "NH1" } },
+	{ AminoAcid::ASN, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::ASN, 1, { "CA", "CB", "CG", "OD1" } },
+	{ AminoAcid::ASP, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::ASP, 1, { "CA", "CB", "CG", "OD1" } },
+	{ AminoAcid::CYS, 0, { "N", "CA", "CB", "SG" } },
+	{ AminoAcid::GLN, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::GLN, 1, { "CA", "CB", "CG", "CD" } },
+	{ AminoAcid::GLN, 2, { "CB", "CG", "CD", "OE1" } },
+	{ AminoAcid::GLU, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::GLU, 1, { "CA", "CB", "CG", "CD" } },
+	{ AminoAcid::GLU, 2, { "CB", "CG", "CD", "OE1" } },
+	{ AminoAcid::HIS, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::HIS, 1, { "CA", "CB", "CG", "ND1" } },
+	{ AminoAcid::ILE, 0, { "N", "CA", "CB", "CG1" } },
+	{ AminoAcid::ILE, 1, { "CA", "CB", "CG1", "CD1" } },
+	{ AminoAcid::LEU, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::LEU, 1, { "CA", "CB", "CG", "CD1" } },
+	{ AminoAcid::LYS, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::LYS, 1, { "CA", "CB", "CG", "CD" } },
+	{ AminoAcid::LYS, 2, { "CB", "CG", "CD", "CE" } },
+	{ AminoAcid::LYS, 3, { "CG", "CD", "CE", "NZ" } },
+	{ AminoAcid::MET, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::MET, 1, { "CA", "CB", "CG", "SD" } },
+	{ AminoAcid::MET, 2, { "CB", "CG", "SD", "CE" } },
+	{ AminoAcid::PHE, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::PHE, 1, { "CA", "CB", "CG", "CD1" } },
+	{ AminoAcid::PRO, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::PRO, 1, { "CA", "CB", "CG", "CD" } },
+	{ AminoAcid::SER, 0, { "N", "CA", "CB", "OG" } },
+	{ AminoAcid::THR, 0, { "N", "CA", "CB", "OG1" } },
+	{ AminoAcid::TRP, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::TRP, 1, { "CA", "CB", "CG", "CD1" } },
+	{ AminoAcid::TYR, 0, { "N", "CA", "CB", "CG" } },
+	{ AminoAcid::TYR, 1, { "CA", "CB", "CG", "CD1" } },
+	{ AminoAcid::VAL, 0, { "N", "CA", "CB", "CG1" } },
+};
+
+namespace
+{
+	using chi_atom_names_t = std::array<std::array<atom_name_t, 4>, 5>;
+
+	// chiAtoms with packed atom names, indexed by AminoAcid, with empty (0) names
+	// for the chi angles an amino acid does not have
+	const std::array<chi_atom_names_t, 20>& packed_chi_atoms()
+	{
+		static const auto chi_atoms = []() {
+			std::array<chi_atom_names_t, 20> result {};
+			for (const auto& [amino_acid, chi, names] : chiAtoms)
+			{
+				auto& packed = result[static_cast<int>(amino_acid)][chi];
+				for (size_t i = 0; i < names.size(); ++i)
+					packed[i] = pack_atom_name(names[i]);
+			}
+			return result;
+		}();
+		return chi_atoms;
+	}
+
+	// the radii above are those of heavy atoms, hydrogens (e.g. of NMR models)
+	// all get the van der Waals radius of Bondi
+	constexpr double hydrogen_radius = 1.20;
+
+	// aminoAcidRadii with packed atom names, so that table backed residues can
+	// look up the radius of each atom without creating strings
+	const std::vector<std::vector<std::pair<atom_name_t, double>>>& packed_amino_acid_radii()
+	{
+		static const auto radii = []() {
+			std::vector<std::vector<std::pair<atom_name_t, double>>> result;
+			for (const auto& amino_acid : aminoAcidRadii)
+			{
+				std::vector<std::pair<atom_name_t, double>> atoms;
+				for (const auto& [name, radius] : amino_acid)
+					atoms.emplace_back(pack_atom_name(name), radius);
+				result.push_back(atoms);
+			}
+			return result;
+		}();
+		return radii;
+	}
+
+	constexpr std::array<atom_name_t, 4> packed_backbone_names
+		= { pack_atom_name("N"), pack_atom_name("CA"), pack_atom_name("C"), pack_atom_name("O") };
+
+	/**
+	 * Copies atoms to a new AtomTable with the backbone atoms first (N, CA, C, O)
+	 * followed by the sidechain atoms in the order they were given.
+	 */
+	template <typename T>
+	std::shared_ptr<AtomTable<T>> make_atom_table(const atomVector<T>& atoms)
+	{
+		auto table = std::make_shared<AtomTable<T>>(atoms.size());
+		std::array<bool, 4> seen_backbone {};
+		arma::uword sidechain_position = 4;
+
+		for (const auto& atom : atoms)
+		{
+			const auto name = pack_atom_name(atom->get_name());
+			auto backbone_slot = std::find(
+				packed_backbone_names.cbegin(), packed_backbone_names.cend(), name);
+
+			arma::uword position;
+			if (backbone_slot != packed_backbone_names.cend())
+			{
+				position = std::distance(packed_backbone_names.cbegin(), backbone_slot);
+				if (seen_backbone[position])
+					throw "Duplicate backbone atom: " + atom->get_name();
+				seen_backbone[position] = true;
+			}
+			else
+				position = sidechain_position++;
+
+			if (position >= atoms.size())
+				throw "Expected four atoms in the backbone, in the order N, CA, C, O";
+
+			table->set_atom(position, static_cast<std::uint8_t>(atom->getAtomicNumber()), name,
+				atom->getX(), atom->getY(), atom->getZ(), 0);
+		}
+		return table;
+	}
+}
+
 /**
  *  The Residue class represent one of the twenty standard amino acids.
  *  A Residue is made of Atom objects which are connected via Bond objects.
@@ -500,16 +630,13 @@ const static stringIndexMap aminoAcidIndex {
 template <typename T>
 Residue<T>::Residue(atomVector<T> atoms_, const std::string& aminoAcidName_,
 	const std::string& residue_name, bool n_terminus, bool c_terminus)
+	: Residue(make_atom_table(atoms_), 0, atoms_.size(), aminoAcidName_, residue_name, n_terminus,
+		c_terminus)
 {
-	backbone = std::vector<int>(4);
-
-	if (aminoAcidIndex.find(aminoAcidName_) != aminoAcidIndex.end())
-	{
-		aminoAcidName = aminoAcidName_;
-		m_amino_acid = static_cast<AminoAcid>(aminoAcidIndex.at(aminoAcidName));
-	}
-	else
-		throw "Unknown amino acid!";
+	// the coordinates and radii live in a table of their own (in backbone-sidechain order),
+	// while the Atom objects are kept in the order they were passed
+	m_table_view = false;
+	sidechain.clear();
 
 	// each atom is responsible to form a bond with the previous atom
 	int i = 0;
@@ -550,21 +677,163 @@ Residue<T>::Residue(atomVector<T> atoms_, const std::string& aminoAcidName_,
 		i++;
 	}
 
-	if (backbone.size() != 4)
+	createBonds();
+}
+
+template <typename T>
+Residue<T>::Residue(std::shared_ptr<AtomTable<T>> table, arma::uword first_atom,
+	arma::uword n_atoms, const std::string& amino_acid_name, const std::string& residue_name,
+	bool n_terminus, bool c_terminus)
+	: m_table(std::move(table))
+	, m_first_atom(first_atom)
+	, m_n_atoms(n_atoms)
+	, m_table_view(true)
+	, xyz(m_table->xyz_view(first_atom, n_atoms))
+	, radii(m_table->radii_view(first_atom, n_atoms))
+	, m_n_terminus(n_terminus)
+	, m_c_terminus(c_terminus)
+	, m_residue_name(residue_name)
+{
+	auto amino_acid = aminoAcidIndex.find(amino_acid_name);
+	if (amino_acid == aminoAcidIndex.end())
+		throw "Unknown amino acid!";
+
+	aminoAcidName = amino_acid_name;
+	m_amino_acid = static_cast<AminoAcid>(amino_acid->second);
+
+	if (m_n_atoms < 4)
+		throw "Expected four atoms in the backbone, got " + std::to_string(m_n_atoms);
+
+	for (arma::uword i = 0; i < 4; ++i)
 	{
-		throw "Expected four atoms in the backbone, got " + std::to_string(backbone.size());
+		if (m_table->name(m_first_atom + i) != packed_backbone_names[i])
+			throw "Expected four atoms in the backbone, in the order N, CA, C, O";
 	}
 
-	m_residue_name = residue_name;
+	backbone = { 0, 1, 2, 3 };
+	sidechain.resize(m_n_atoms - 4);
+	std::iota(sidechain.begin(), sidechain.end(), 4);
 
-	createBonds();
+	const auto& amino_acid_radii = packed_amino_acid_radii().at(static_cast<int>(m_amino_acid));
+	for (arma::uword i = m_first_atom; i < m_first_atom + m_n_atoms; ++i)
+	{
+		const auto name = m_table->name(i);
+		auto radius = std::find_if(amino_acid_radii.cbegin(), amino_acid_radii.cend(),
+			[name](const auto& atom_radius) { return atom_radius.first == name; });
+		if (radius != amino_acid_radii.cend())
+			m_table->radii().at(i) = static_cast<T>(radius->second);
+		else if (m_table->element(i) == 1)
+			m_table->radii().at(i) = static_cast<T>(hydrogen_radius);
+		else
+			throw "Unknown atom: " + unpack_atom_name(name);
+	}
 
-	m_n_terminus = n_terminus;
-	m_c_terminus = c_terminus;
+	resolve_chi_atoms();
 }
 
 template <typename T>
-void Residue<T>::createBonds()
+Residue<T>::Residue(const Residue& other, std::shared_ptr<AtomTable<T>> table)
+	: m_table(std::move(table))
+	, m_first_atom(other.m_first_atom)
+	, m_n_atoms(other.m_n_atoms)
+	, m_table_view(true)
+	, xyz(m_table->xyz_view(m_first_atom, m_n_atoms))
+	, radii(m_table->radii_view(m_first_atom, m_n_atoms))
+	, m_n_terminus(other.m_n_terminus)
+	, m_c_terminus(other.m_c_terminus)
+	, backbone(other.backbone)
+	, sidechain(other.sidechain)
+	, aminoAcidName(other.aminoAcidName)
+	, m_amino_acid(other.m_amino_acid)
+	, m_residue_name(other.m_residue_name)
+	, m_chi_atoms(other.m_chi_atoms)
+{
+}
+
+/**
+ * Finds the atoms of each chi angle once, so that the chi kernels only gather
+ * coordinates instead of searching the atoms by name for every residue.
+ */
+template <typename T>
+void Residue<T>::resolve_chi_atoms() noexcept
+{
+	const auto& chi_atoms = packed_chi_atoms()[static_cast<int>(m_amino_acid)];
+	for (int chi = 0; chi < n_chi_angles; ++chi)
+	{
+		for (size_t i = 0; i < 4; ++i)
+		{
+			const atom_name_t name = chi_atoms[chi][i];
+			int& index = m_chi_atoms[chi][i];
+			index = name == 0 ? no_chi_atom : missing_chi_atom;
+			for (arma::uword atom = 0; name != 0 && atom < m_n_atoms; ++atom)
+			{
+				if (m_table->name(m_first_atom + atom) == name)
+				{
+					index = static_cast<int>(atom);
+					break;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * The peptide bonds of a residue are created with its atoms, on both sides,
+ * so that the bond graph is the same as for residues linked with link.
+ * Each peptide bond is created once, by the residue on its N side, and only
+ * the atoms of the two residues are created, so this does not recurse along
+ * the chain.
+ */
+template <typename T>
+void Residue<T>::materialise_atoms() const
+{
+	if (!m_table_view)
+		return;
+
+	create_atoms();
+	create_peptide_bond();
+	if (auto next = m_next.lock())
+		next->create_peptide_bond();
+}
+
+template <typename T>
+void Residue<T>::create_atoms() const
+{
+	std::call_once(m_atoms_materialised, [this]() {
+		atoms.reserve(m_n_atoms);
+		for (arma::uword i = 0; i < m_n_atoms; ++i)
+		{
+			atoms.emplace_back(std::make_shared<Atom<T>>(m_table, m_first_atom + i));
+			atomMap[atoms.back()->get_name()] = static_cast<int>(i);
+		}
+		createBonds();
+	});
+}
+
+template <typename T>
+void Residue<T>::create_peptide_bond() const
+{
+	std::call_once(m_peptide_bond_created, [this]() {
+		auto previous = m_previous.lock();
+		if (!previous)
+			return;
+		create_atoms();
+		previous->create_atoms();
+		// as in link, the N of this residue with the C of the previous one
+		atoms[backbone[0]]->addBond(previous->atoms[previous->backbone[2]], 1);
+	});
+}
+
+template <typename T>
+void Residue<T>::link_table_views(
+	const std::shared_ptr<Residue<T>>& previous, const std::shared_ptr<Residue<T>>& next)
+{
+	next->m_previous = previous;
+	previous->m_next = next;
+}
+
+template <typename T>
+void Residue<T>::createBonds() const
 {
 
 	bool first = true;
@@ -598,22 +867,12 @@ void Residue<T>::createBonds()
 			else
 				throw "Unknown atom: " + name;
 
-			//            std::cout << "Bond: from: " << atomPair[0] << " to: " << atomPair[1] <<
-			//            std::endl;
-
 			// does bond exist?
 			if (!atom->hasBond(atoms[atomMap[atomPair[1]]]))
 			{
 				atom->addBond(atoms[atomMap[atomPair[1]]], 1);
-				//                std::cout << atom->get_name() << " n bond: " <<
-				//                atom->getNumberOfBonds()
-				//                          << " " << atoms[atomMap[atomPair[1]]]->get_name() << " n
-				//                          bonds: "
-				//                          << atoms[atomMap[atomPair[1]]]->getNumberOfBonds() <<
-				//                          std::endl;
 			}
 		}
-		//        std::cout << "Completed " << atom->get_name() << std::endl;
 	}
 
 	switch (m_amino_acid)
@@ -638,33 +897,13 @@ void Residue<T>::createBonds()
 	default:
 		break;
 	}
-
-	xyz.resize(3, atoms.size());
-	radii.resize(atoms.size());
-
-	arma::uword i = 0;
-	for (const auto& atom : getBackbone())
-	{
-		xyz.at(0, i) = atom->getX();
-		xyz.at(1, i) = atom->getY();
-		xyz.at(2, i) = atom->getZ();
-		radii.at(i) = atom->getRadius();
-		i++;
-	}
-	for (const auto& atom : get_sidechain())
-	{
-		xyz.at(0, i) = atom->getX();
-		xyz.at(1, i) = atom->getY();
-		xyz.at(2, i) = atom->getZ();
-		radii.at(i) = atom->getRadius();
-		i++;
-	}
 }
 
 template <typename T>
 void Residue<T>::link(std::shared_ptr<Residue<T>> residue_)
 {
 	// links this (C-terminus) with residue_ (N-terminus)
+	materialise_atoms();
 	atoms[backbone[0]]->addBond(residue_->getBackbone()[2], 1);
 }
 
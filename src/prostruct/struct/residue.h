@@ -10,9 +10,13 @@
 #define PROSTRUCT_RESIDUE_H
 
 #include <prostruct/struct/atom.h>
+#include <prostruct/struct/atom_table.h>
 #include <prostruct/struct/utils.h>
 #include <prostruct/utils/type_traits.h>
 
+#include <array>
+#include <mutex>
+
 namespace prostruct
 {
 
@@ -30,10 +34,31 @@ namespace prostruct
 		//    Residue(std::unique_ptr<Atom> atoms...);
 		Residue(atomVector<T>, const std::string&, const std::string&, bool = false, bool = false);
 
+#ifndef SWIG
+		/**
+		 * A residue made of the atoms [first_atom, first_atom + n_atoms) of an
+		 * AtomTable, ordered N, CA, C, O and then the sidechain. Hydrogens (of
+		 * element 1) are kept, with the van der Waals radius of Bondi.
+		 * No Atom objects are created unless they are requested, in which case
+		 * they are views into the table (see getAtoms).
+		 */
+		Residue(std::shared_ptr<AtomTable<T>> table, arma::uword first_atom, arma::uword n_atoms,
+			const std::string& amino_acid_name, const std::string& residue_name,
+			bool n_terminus = false, bool c_terminus = false);
+
+		/**
+		 * A copy of other made of the same range of atoms of table, which is a
+		 * copy of the table of other. Its Atom objects are views into table,
+		 * created on first use, and it is not linked to other residues.
+		 */
+		Residue(const Residue& other, std::shared_ptr<AtomTable<T>> table);
+#endif
+
 		inline static const std::vector<std::string> backbone_atom_names = { "C", "CA", "N", "O" };
 
 		atomVector<T> getBackbone() const noexcept
 		{
+			materialise_atoms();
 			std::vector<std::shared_ptr<Atom<T>>> backboneAtoms;
 			for (auto const& i : backbone)
 			{
@@ -44,6 +69,9 @@ namespace prostruct
 
 		AminoAcid get_amino_acid_type() const noexcept { return m_amino_acid; }
 
+		/** The name of the amino acid, e.g. ALA */
+		std::string get_amino_acid_name() const noexcept { return aminoAcidName; }
+
 		arma::Mat<T> get_backbone_atoms() const noexcept
 		{
 			return xyz(arma::span::all, arma::span(0, 3));
@@ -51,6 +79,7 @@ namespace prostruct
 
 		atomVector<T> get_sidechain() const noexcept
 		{
+			materialise_atoms();
 			std::vector<std::shared_ptr<Atom<T>>> sidechainAtoms;
 			for (auto const& i : sidechain)
 			{
@@ -64,27 +93,86 @@ namespace prostruct
 			if (get_amino_acid_type() == AminoAcid::GLY)
 				return arma::Mat<T>(3, 0);
 			else
-				return xyz(arma::span::all, arma::span(4, atoms.size() - 1));
+				return xyz(arma::span::all, arma::span(4, m_n_atoms - 1));
 		}
 
-		std::shared_ptr<Atom<T>> operator[](const int index) const { return atoms[index]; }
+		std::shared_ptr<Atom<T>> operator[](const int index) const
+		{
+			materialise_atoms();
+			return atoms[index];
+		}
 
 		arma::Mat<T> get_xyz() const noexcept { return xyz; }
 
 		std::string get_name() const noexcept { return m_residue_name; }
 
-		std::shared_ptr<Atom<T>> get_atom(int index) const noexcept { return atoms[index]; }
+		std::shared_ptr<Atom<T>> get_atom(int index) const noexcept
+		{
+			materialise_atoms();
+			return atoms[index];
+		}
 
 		void link(std::shared_ptr<Residue<T>>);
 
-		void createBonds();
+#ifndef SWIG
+		/**
+		 * Records that the table-backed residues previous and next are adjacent in
+		 * a chain, so that the peptide bond between the C of previous and the N of
+		 * next is created when the atoms of either residue are materialised.
+		 */
+		static void link_table_views(
+			const std::shared_ptr<Residue<T>>& previous, const std::shared_ptr<Residue<T>>& next);
+#endif
+
+		void createBonds() const;
 
-		int n_atoms() const noexcept { return atoms.size(); };
+		int n_atoms() const noexcept { return static_cast<int>(m_n_atoms); };
 
-		atomVector<T> getAtoms() const noexcept { return atoms; }
+		/**
+		 * Returns the Atom objects of this residue. For residues that were built
+		 * from an AtomTable these are created on the first call.
+		 */
+		atomVector<T> getAtoms() const noexcept
+		{
+			materialise_atoms();
+			return atoms;
+		}
 
 		arma::Col<T> getRadii() const noexcept { return radii; }
 
+		/**
+		 * Whether the atoms of this residue are only stored in the AtomTable,
+		 * i.e. the residue was not built from Atom objects.
+		 */
+		bool is_table_view() const noexcept { return m_table_view; }
+
+#ifndef SWIG
+		std::shared_ptr<AtomTable<T>> get_atom_table() const noexcept { return m_table; }
+
+		/** Index of the first atom of this residue in the AtomTable */
+		arma::uword first_atom() const noexcept { return m_first_atom; }
+#endif
+
+		/** The number of chi angles of the amino acid with the most (ARG) */
+		static constexpr int n_chi_angles = 5;
+		/** Index of the atoms of a chi angle that the amino acid does not have */
+		static constexpr int no_chi_atom = -1;
+		/** Index of an atom of a chi angle that is missing from the residue */
+		static constexpr int missing_chi_atom = -2;
+
+#ifndef SWIG
+		/**
+		 * The indices (columns of get_xyz) of the four atoms that define the chi
+		 * angle chi (0 for chi1, ..., 4 for chi5), found when the residue is built.
+		 */
+		const std::array<int, 4>& get_chi_atom_indices(int chi) const noexcept
+		{
+			return m_chi_atoms[chi];
+		}
+
+		const arma::Mat<T>& xyz_ref() const noexcept { return xyz; }
+#endif
+
 		bool is_n_terminus() const noexcept { return m_n_terminus; }
 
 		bool is_c_terminus() const noexcept { return m_c_terminus; }
@@ -97,27 +185,25 @@ namespace prostruct
 			if constexpr (expect_one::value)
 				max_result.set_size(sizeof...(Args));
 			else
-				max_result.set_size(atoms.size());
+				max_result.set_size(m_n_atoms);
 
-			std::vector<std::string> vec = { patterns... };
+			const std::array<atom_name_t, sizeof...(Args)> packed_patterns
+				= { pack_atom_name(patterns)... };
 			arma::uword result_idx = 0;
 
-			for (auto atom = atoms.cbegin(); atom != atoms.cend(); ++atom)
+			for (arma::uword atom = 0; atom < m_n_atoms; ++atom)
 			{
-				const auto pattern_result = std::find_if(vec.cbegin(), vec.cend(),
-					[&atom](const auto& pattern) { return pattern == atom->get()->get_name(); });
-
-				if (pattern_result == vec.cend())
+				const auto name = m_table->name(m_first_atom + atom);
+				if (std::find(packed_patterns.cbegin(), packed_patterns.cend(), name)
+					== packed_patterns.cend())
 					continue;
-				else
+
+				max_result(result_idx) = atom;
+				++result_idx;
+				if constexpr (expect_one::value)
 				{
-					max_result(result_idx) = std::distance(atoms.cbegin(), atom);
-					++result_idx;
-					if constexpr (expect_one::value)
-					{
-						if (result_idx == sizeof...(Args))
-							break;
-					}
+					if (result_idx == sizeof...(Args))
+						break;
 				}
 			}
 			if constexpr (expect_one::value)
@@ -136,39 +222,12 @@ namespace prostruct
 			}
 			if constexpr (utils::all_same_v<Args...>)
 			{
-				arma::Mat<T> max_result;
-				if constexpr (expect_one::value)
-					max_result.set_size(3, sizeof...(Args));
-				else
-					max_result.set_size(3, atoms.size());
-
-				std::vector<std::string> vec = { idx... };
-				arma::uword result_idx = 0;
-
-				for (auto atom = atoms.cbegin(); atom != atoms.cend(); ++atom)
-				{
-					const auto pattern_result
-						= std::find_if(vec.cbegin(), vec.cend(), [&atom](const auto& pattern) {
-							  return pattern == atom->get()->get_name();
-						  });
-
-					if (pattern_result == vec.cend())
-						continue;
-					else
-					{
-						max_result.col(result_idx) = xyz.col(std::distance(atoms.cbegin(), atom));
-						++result_idx;
-						if constexpr (expect_one::value)
-						{
-							if (result_idx == sizeof...(Args))
-								break;
-						}
-					}
-				}
-				if constexpr (expect_one::value)
-					return max_result;
-				else
-					return max_result.head(result_idx);
+				const arma::Col<arma::uword> indices
+					= get_atom_indices<expect_one>(idx...);
+				arma::Mat<T> result(3, indices.n_elem);
+				for (arma::uword i = 0; i < indices.n_elem; ++i)
+					result.col(i) = xyz.col(indices(i));
+				return result;
 			}
 		}
 
@@ -179,6 +238,20 @@ namespace prostruct
 #endif
 
 	private:
+		void materialise_atoms() const;
+
+		/** Creates the Atom objects of a table-backed residue and the bonds between them */
+		void create_atoms() const;
+
+		/** Creates the peptide bond to m_previous, if any */
+		void create_peptide_bond() const;
+
+		void resolve_chi_atoms() noexcept;
+
+		std::shared_ptr<AtomTable<T>> m_table; /**< the table holding the atoms of this residue */
+		arma::uword m_first_atom; /**< index of the first atom in m_table */
+		arma::uword m_n_atoms;
+		bool m_table_view; /**< true if built from a table rather than Atom objects */
 		arma::Mat<T> xyz;
 		arma::Col<T> radii;
 		bool m_n_terminus;
@@ -190,8 +263,13 @@ namespace prostruct
 		std::string aminoAcidName; /**< Name of the amino acid, e.g. ALA */
 		enum AminoAcid m_amino_acid; /**< Amino acid enum, e.g. ALA */
 		std::string m_residue_name; /**< Name of the residue, e.g. ALA1 */
-		atomVector<T> atoms; /**< A vector with the pointers to the Atom objects */
-		std::map<std::string, int> atomMap; /**< Map atom name to internal index */
+		mutable atomVector<T> atoms; /**< A vector with the pointers to the Atom objects */
+		mutable std::map<std::string, int> atomMap; /**< Map atom name to internal index */
+		mutable std::once_flag m_atoms_materialised;
+		mutable std::once_flag m_peptide_bond_created;
+		std::weak_ptr<Residue<T>> m_previous; /**< see link_table_views */
+		std::weak_ptr<Residue<T>> m_next;
+		std::array<std::array<int, 4>, n_chi_angles> m_chi_atoms; /**< see get_chi_atom_indices */
 	};
 }
 
@@ -0,0 +1,85 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#ifndef PROSTRUCT_BOUNDED_QUEUE_H
+#define PROSTRUCT_BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace prostruct
+{
+	/**
+	 * A first in first out queue of at most capacity values, shared by
+	 * producer and consumer threads: push blocks while the queue is full and pop
+	 * while it is empty. Closing the queue wakes every waiting thread, values
+	 * already queued can still be popped.
+	 */
+	template <typename T>
+	class BoundedQueue
+	{
+	public:
+		explicit BoundedQueue(size_t capacity)
+			: m_capacity(capacity > 0 ? capacity : 1)
+		{
+		}
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+		/** Returns false (and drops value) if the queue is closed */
+		bool push(T value)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_full.wait(lock, [this] { return m_closed || m_values.size() < m_capacity; });
+			if (m_closed)
+				return false;
+			m_values.push_back(std::move(value));
+			lock.unlock();
+			m_not_empty.notify_one();
+			return true;
+		}
+
+		/** Returns an empty optional once the queue is closed and empty */
+		std::optional<T> pop()
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_not_empty.wait(lock, [this] { return m_closed || !m_values.empty(); });
+			if (m_values.empty())
+				return std::nullopt;
+			std::optional<T> result(std::move(m_values.front()));
+			m_values.pop_front();
+			lock.unlock();
+			m_not_full.notify_one();
+			return result;
+		}
+
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_closed = true;
+			}
+			m_not_full.notify_all();
+			m_not_empty.notify_all();
+		}
+
+	private:
+		size_t m_capacity;
+		std::deque<T> m_values;
+		bool m_closed = false;
+		std::mutex m_mutex;
+		std::condition_variable m_not_full;
+		std::condition_variable m_not_empty;
+	};
+}
+
+#endif // PROSTRUCT_BOUNDED_QUEUE_H
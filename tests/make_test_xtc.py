@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+#
+# This file is subject to the terms and conditions defined in
+# file 'LICENSE', which is part of this source code package.
+#
+# Authors: Gil Hoben
+#
+"""
+Writes tests/test.xtc, the XTC trajectory of trajectoryTest.cpp:
+
+    python3 tests/make_test_xtc.py tests/test.pdb tests/test.xtc
+
+The trajectory has three frames with the ATOM records of test.pdb translated by
+(0, 0, 0), (10, -5, 2) and (-3.5, 1.25, 7) Angstrom, compressed with a
+precision of 1000 (0.01 Angstrom). The compression is a port of
+xdrfile_compress_coord_float from the xdrfile library of GROMACS (xdrfile.c),
+using only the standard library. The result can be checked with an independent
+reader, e.g. "gmx dump -f tests/test.xtc" or MDAnalysis.
+"""
+
+import struct
+import sys
+
+MAGIC = 1995
+
+# the sizes of the small differences between atoms, as in xdrfile.c
+MAGICINTS = [
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 8, 10, 12, 16, 20, 25, 32, 40, 50, 64, 80, 101, 128, 161,
+    203, 256, 322, 406, 512, 645, 812, 1024, 1290, 1625, 2048, 2580, 3250, 4096, 5060,
+    6501, 8192, 10321, 13003, 16384, 20642, 26007, 32768, 41285, 52015, 65536, 82570,
+    104031, 131072, 165140, 208063, 262144, 330280, 416127, 524287, 660561, 832255,
+    1048576, 1321122, 1664510, 2097152, 2642245, 3329021, 4194304, 5284491, 6658042,
+    8388607, 10568983, 13316085, 16777216,
+]
+FIRSTIDX = 9
+LASTIDX = len(MAGICINTS)
+
+SHIFTS = [(0.0, 0.0, 0.0), (10.0, -5.0, 2.0), (-3.5, 1.25, 7.0)]
+
+
+class BitWriter:
+    """The bits of the compressed coordinates, most significant bit first"""
+
+    def __init__(self):
+        self.bits = []
+
+    def send_bits(self, n_bits, value):
+        for bit in range(n_bits - 1, -1, -1):
+            self.bits.append((value >> bit) & 1)
+
+    def to_bytes(self):
+        bits = self.bits + [0] * (-len(self.bits) % 8)
+        return bytes(
+            int("".join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits), 8))
+
+
+def sizeofint(size):
+    """The number of bits of size"""
+    num = 1
+    n_bits = 0
+    while size >= num and n_bits < 32:
+        n_bits += 1
+        num <<= 1
+    return n_bits
+
+
+def sizeofints(sizes):
+    """The number of bits of the product of sizes, computed byte by byte as xdrfile.c"""
+    product = [1] + [0] * 31
+    n_bytes = 1
+    for size in sizes:
+        carry = 0
+        byte = 0
+        while byte < n_bytes:
+            carry = product[byte] * size + carry
+            product[byte] = carry & 0xFF
+            carry >>= 8
+            byte += 1
+        while carry != 0:
+            product[byte] = carry & 0xFF
+            byte += 1
+            carry >>= 8
+        n_bytes = byte
+    num = 1
+    n_bits = 0
+    n_bytes -= 1
+    while product[n_bytes] >= num:
+        n_bits += 1
+        num *= 2
+    return n_bits + n_bytes * 8
+
+
+def send_ints(writer, n_bits, sizes, values):
+    """Sends three integers below sizes as one integer of n_bits bits, low byte first"""
+    for value, size in zip(values, sizes):
+        assert 0 <= value < size
+    combined = (values[0] * sizes[1] + values[1]) * sizes[2] + values[2]
+    assert combined < (1 << n_bits)
+    shift = 0
+    while n_bits > 8:
+        writer.send_bits(8, (combined >> shift) & 0xFF)
+        shift += 8
+        n_bits -= 8
+    if n_bits > 0:
+        writer.send_bits(n_bits, (combined >> shift) & ((1 << n_bits) - 1))
+
+
+def compress(coordinates, precision):
+    """The compressed coordinates (in nm) of a frame, from its precision on"""
+    n_atoms = len(coordinates)
+    ints = []
+    for atom in coordinates:
+        scaled = [value * precision for value in atom]
+        ints.append([int(v + 0.5) if v >= 0 else int(v - 0.5) for v in scaled])
+
+    minint = [min(atom[d] for atom in ints) for d in range(3)]
+    maxint = [max(atom[d] for atom in ints) for d in range(3)]
+    mindiff = 2 ** 31 - 1
+    for i in range(1, n_atoms):
+        mindiff = min(mindiff, sum(abs(ints[i][d] - ints[i - 1][d]) for d in range(3)))
+
+    sizeint = [maxint[d] - minint[d] + 1 for d in range(3)]
+    bitsizeint = [0, 0, 0]
+    if (sizeint[0] | sizeint[1] | sizeint[2]) > 0xFFFFFF:
+        bitsizeint = [sizeofint(size) for size in sizeint]
+        bitsize = 0
+    else:
+        bitsize = sizeofints(sizeint)
+
+    smallidx = FIRSTIDX
+    while smallidx < LASTIDX and MAGICINTS[smallidx] < mindiff:
+        smallidx += 1
+    first_smallidx = smallidx
+
+    maxidx = min(LASTIDX, smallidx + 8)
+    minidx = maxidx - 8
+    smaller = MAGICINTS[max(FIRSTIDX, smallidx - 1)] // 2
+    smallnum = MAGICINTS[smallidx] // 2
+    sizesmall = [MAGICINTS[smallidx]] * 3
+    larger = MAGICINTS[maxidx] // 2
+
+    writer = BitWriter()
+    prevcoord = [0, 0, 0]
+    prevrun = -1
+    i = 0
+    while i < n_atoms:
+        is_small = False
+        current = ints[i]
+        if smallidx < maxidx and i >= 1 and all(
+                abs(current[d] - prevcoord[d]) < larger for d in range(3)):
+            is_smaller = 1
+        elif smallidx > minidx:
+            is_smaller = -1
+        else:
+            is_smaller = 0
+        # a close next atom is sent first, as water molecules start with O
+        if i + 1 < n_atoms and all(
+                abs(current[d] - ints[i + 1][d]) < smallnum for d in range(3)):
+            ints[i], ints[i + 1] = ints[i + 1], ints[i]
+            is_small = True
+        current = ints[i]
+
+        offsets = [current[d] - minint[d] for d in range(3)]
+        if bitsize == 0:
+            for d in range(3):
+                writer.send_bits(bitsizeint[d], offsets[d])
+        else:
+            send_ints(writer, bitsize, sizeint, offsets)
+
+        prevcoord = list(current)
+        i += 1
+        run = 0
+        small_values = []
+        if not is_small and is_smaller == -1:
+            is_smaller = 0
+        while is_small and run < 24:
+            current = ints[i]
+            if is_smaller == -1 and sum(
+                    (current[d] - prevcoord[d]) ** 2 for d in range(3)) >= smaller * smaller:
+                is_smaller = 0
+            small_values += [current[d] - prevcoord[d] + smallnum for d in range(3)]
+            run += 3
+            prevcoord = list(current)
+            i += 1
+            is_small = i < n_atoms and all(
+                abs(ints[i][d] - prevcoord[d]) < smallnum for d in range(3))
+
+        if run != prevrun or is_smaller != 0:
+            prevrun = run
+            writer.send_bits(1, 1)
+            writer.send_bits(5, run + is_smaller + 1)
+        else:
+            writer.send_bits(1, 0)
+        for k in range(0, run, 3):
+            send_ints(writer, smallidx, sizesmall, small_values[k:k + 3])
+
+        if is_smaller != 0:
+            smallidx += is_smaller
+            if is_smaller < 0:
+                smallnum = smaller
+                smaller = MAGICINTS[smallidx - 1] // 2 if smallidx > FIRSTIDX else 0
+            else:
+                smaller = smallnum
+                smallnum = MAGICINTS[smallidx] // 2
+            sizesmall = [MAGICINTS[smallidx]] * 3
+
+    data = writer.to_bytes()
+    result = struct.pack(">f3i3ii", precision, *minint, *maxint, first_smallidx)
+    result += struct.pack(">i", len(data)) + data + b"\0" * (-len(data) % 4)
+    return result
+
+
+def frame(coordinates, step, time, precision=1000.0):
+    """An XTC frame of coordinates (in nm) in a 5 nm cubic box"""
+    n_atoms = len(coordinates)
+    result = struct.pack(">iiif", MAGIC, n_atoms, step, time)
+    result += struct.pack(">9f", 5, 0, 0, 0, 5, 0, 0, 0, 5)
+    result += struct.pack(">i", n_atoms)
+    # xdrfile stores up to 9 atoms uncompressed
+    if n_atoms <= 9:
+        for atom in coordinates:
+            result += struct.pack(">3f", *atom)
+    else:
+        result += compress(coordinates, precision)
+    return result
+
+
+def main(pdb_file, xtc_file):
+    atoms = []
+    with open(pdb_file) as pdb:
+        for line in pdb:
+            if line.startswith("ATOM"):
+                atoms.append([float(line[30:38]), float(line[38:46]), float(line[46:54])])
+
+    with open(xtc_file, "wb") as xtc:
+        for step, shift in enumerate(SHIFTS):
+            # XTC coordinates are in nm
+            coordinates = [[(atom[d] + shift[d]) / 10 for d in range(3)] for atom in atoms]
+            xtc.write(frame(coordinates, step, step * 2.0))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit("usage: make_test_xtc.py test.pdb test.xtc")
+    main(sys.argv[1], sys.argv[2])
@@ -55,6 +55,46 @@ TYPED_TEST(PDBTest, LoadPDB)
 	ASSERT_EQ(pdb.get_xyz().n_cols, 1867);
 }
 
+TYPED_TEST(PDBTest, SharedCoordinates)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	auto copy = pdb;
+	const arma::Mat<TypeParam> original_xyz = pdb.get_xyz();
+
+	pdb.recentre();
+
+	auto xyz = pdb.get_xyz();
+	auto chain_H = pdb.get_chain("H");
+	auto residue = pdb.get_residues()[5];
+
+	EXPECT_TRUE(arma::approx_equal(chain_H->get_xyz(),
+		xyz.cols(chain_H->first_atom(), chain_H->first_atom() + chain_H->n_atoms() - 1),
+		"absdiff", 0));
+	EXPECT_TRUE(arma::approx_equal(residue->get_xyz(),
+		xyz.cols(residue->first_atom(), residue->first_atom() + residue->n_atoms() - 1),
+		"absdiff", 0));
+	EXPECT_NEAR(residue->get_atom(0)->getX(), xyz(0, residue->first_atom()), 0);
+
+	// a copy has its own coordinates, shared by its chains and residues
+	auto copy_chain_H = copy.get_chain("H");
+	auto copy_residue = copy.get_residues()[5];
+	EXPECT_TRUE(arma::approx_equal(copy.get_xyz(), original_xyz, "absdiff", 0));
+	EXPECT_TRUE(arma::approx_equal(copy_chain_H->get_xyz(),
+		original_xyz.cols(chain_H->first_atom(), chain_H->first_atom() + chain_H->n_atoms() - 1),
+		"absdiff", 0));
+	EXPECT_TRUE(arma::approx_equal(copy_residue->get_xyz(),
+		original_xyz.cols(residue->first_atom(), residue->first_atom() + residue->n_atoms() - 1),
+		"absdiff", 0));
+	EXPECT_NE(copy_residue->get_atom_table(), residue->get_atom_table());
+	EXPECT_EQ(copy_chain_H->get_atom_table(), copy.get_atom_table());
+
+	copy = pdb;
+	EXPECT_TRUE(arma::approx_equal(copy.get_xyz(), xyz, "absdiff", 0));
+	EXPECT_TRUE(
+		arma::approx_equal(copy.get_chain("H")->get_xyz(), chain_H->get_xyz(), "absdiff", 0));
+	EXPECT_NE(copy.get_atom_table(), pdb.get_atom_table());
+}
+
 TYPED_TEST(PDBTest, PredictBackboneHBonds)
 {
 
@@ -77,6 +117,26 @@ TYPED_TEST(PDBTest, ShrakeRupley)
 	EXPECT_NEAR(asa.at(0), 43.593459609528409, get_epsilon<TypeParam>());
 }
 
+TYPED_TEST(PDBTest, ResidueSASA)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	auto asa = pdb.compute_shrake_rupley(1.4, 960);
+	auto residue_asa = pdb.compute_residue_sasa(1.4, 960);
+	auto relative_asa = pdb.compute_relative_sasa(1.4, 960);
+	auto chain_asa = pdb.compute_chain_sasa(1.4, 960);
+	auto total = pdb.compute_total_sasa(1.4, 960);
+
+	ASSERT_EQ(residue_asa.n_elem, pdb.n_residues());
+	ASSERT_EQ(chain_asa.n_elem, pdb.n_chains());
+
+	const auto first_residue_atoms = pdb.get_residues()[0]->n_atoms();
+	EXPECT_NEAR(residue_asa.at(0), arma::accu(asa.head(first_residue_atoms)), 1e-2);
+	EXPECT_NEAR(
+		relative_asa.at(0), residue_asa.at(0) / geometry::max_asa(AminoAcid::ASP), 1e-4);
+	EXPECT_NEAR(arma::accu(residue_asa), total, 1.0);
+	EXPECT_NEAR(arma::accu(chain_asa), total, 1.0);
+}
+
 TYPED_TEST(PDBTest, KabschSander)
 {
 
@@ -90,6 +150,85 @@ TYPED_TEST(PDBTest, KabschSander)
 	EXPECT_NEAR(E(2, 25), -1.9521032812185981, get_epsilon<TypeParam>());
 }
 
+TYPED_TEST(PDBTest, KabschSanderSparse)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+
+	auto E = pdb.compute_kabsch_sander();
+	auto hbonds = pdb.compute_kabsch_sander_sparse();
+
+	ASSERT_EQ(hbonds.n_residues(), pdb.n_residues());
+	EXPECT_TRUE(hbonds.is_bonded(2, 25));
+
+	// the sparse bonds of each donor are the two lowest energies of its column
+	for (arma::uword donor = 1; donor < hbonds.n_residues(); ++donor)
+	{
+		if (pdb.get_residues()[donor]->get_amino_acid_type() == AminoAcid::PRO
+			|| pdb.get_residues()[donor]->is_n_terminus())
+			continue;
+
+		arma::Col<TypeParam> column = arma::sort(E.col(donor));
+		EXPECT_NEAR(hbonds.donor_bonds[donor][0].energy, std::min<TypeParam>(column(0), 0),
+			get_epsilon<TypeParam>());
+		EXPECT_NEAR(hbonds.donor_bonds[donor][1].energy, std::min<TypeParam>(column(1), 0),
+			get_epsilon<TypeParam>());
+	}
+
+	auto bonds = pdb.compute_hbonds();
+	ASSERT_EQ(bonds.n_rows, 3);
+	EXPECT_GT(bonds.n_cols, 0);
+}
+
+TYPED_TEST(PDBTest, DSSP)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+
+	// the secondary structure and sheets of DSSP (the classic eight codes, without
+	// the polyproline helices of DSSP 4), one character per residue of chains L and H
+	const std::string expected_ss =
+		"   EEEE SEEEE TTS EEEEEEESS  B TTS B EEEEEE TTS  EEEEETTTEE TT  TTEEEEEETTEEEEEE"
+		" S  GGG EEEEEEE SSS EE   EEEEE     EEEEE  EEE TT  EEEEEEEESS GGGEEEEEEEE TTS EEE"
+		"EEEE TTSS EEE TTTTTTEEEEEETTTTEEEEEE S  GGG EEEEEEEEEESSS TTSSS  B   EEEEE  ";
+	const std::string expected_sheets =
+		"   AAAA  BBBB     AAAAAAA    C     C BBBBBB      BBBBB   BB       AAAAAA  AAAAAA"
+		"        BBBBBBB     BB   BBBBB     DDDDD  BBB     DDDDDDDD      BBBBBBBB     BBB"
+		"BBBB      BBB       DDDDDD    DDDDDD        BBBBBBBBBB           B   BBBBB  ";
+
+	EXPECT_EQ(pdb.compute_dssp(), expected_ss);
+	EXPECT_EQ(pdb.compute_dssp_sheets(), expected_sheets);
+
+	// an ideal alpha helix (residues 6 to 25) between two extended segments
+	auto helix = PDB<TypeParam>("helix.pdb");
+	EXPECT_EQ(helix.compute_dssp(), "     HHHHHHHHHHHHHHHHHHHHS    ");
+	EXPECT_EQ(helix.compute_dssp_sheets(), std::string(30, ' '));
+}
+
+TYPED_TEST(PDBTest, RMSD)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	auto other = PDB<TypeParam>("test.pdb");
+
+	// a translation by t has an RMSD of |t|
+	const arma::Col<TypeParam> centroid = pdb.calculate_centroid();
+	other.recentre();
+	EXPECT_NEAR(pdb.calculate_RMSD(other), arma::norm(centroid), get_epsilon<TypeParam>());
+
+	arma::arma_rng::set_seed(3);
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+	const arma::Mat<TypeParam> perturbed
+		= xyz + arma::randn<arma::Mat<TypeParam>>(3, xyz.n_cols);
+
+	long double sum = 0;
+	for (arma::uword i = 0; i < xyz.n_elem; ++i)
+	{
+		const long double deviation = static_cast<long double>(xyz(i)) - perturbed(i);
+		sum += deviation * deviation;
+	}
+	const auto expected = static_cast<double>(std::sqrt(sum / xyz.n_cols));
+
+	EXPECT_NEAR(geometry::rmsd(xyz, perturbed), expected, expected * 1e-6);
+}
+
 TYPED_TEST(PDBTest, Kabsch_RMSD)
 {
 
@@ -100,6 +239,41 @@ TYPED_TEST(PDBTest, Kabsch_RMSD)
 	EXPECT_NEAR(rmsd, 0.0, get_epsilon<TypeParam>());
 }
 
+TYPED_TEST(PDBTest, KabschRMSDMatrix)
+{
+	auto pdb = std::make_shared<PDB<TypeParam>>("test.pdb");
+	auto moved = std::make_shared<PDB<TypeParam>>("test.pdb");
+	auto perturbed = std::make_shared<PDB<TypeParam>>("test.pdb");
+	moved->recentre();
+
+	// the coordinates in file order, with noise
+	arma::arma_rng::set_seed(1);
+	const arma::Mat<TypeParam> xyz = pdb->get_xyz();
+	const auto& positions = perturbed->get_table_positions();
+	arma::Mat<TypeParam> noisy(3, positions.size());
+	for (arma::uword atom = 0; atom < positions.size(); ++atom)
+		noisy.col(atom) = xyz.col(positions[atom]) + arma::randn<arma::Col<TypeParam>>(3);
+	perturbed->set_file_order_xyz(noisy.memptr());
+
+	const std::vector<std::shared_ptr<PDB<TypeParam>>> structures = { pdb, moved, perturbed };
+	const arma::Mat<TypeParam> matrix = PDB<TypeParam>::kabsch_rmsd_matrix(structures);
+	const arma::Col<TypeParam> condensed
+		= PDB<TypeParam>::condensed_kabsch_rmsd_matrix(structures);
+
+	ASSERT_EQ(matrix.n_rows, 3);
+	ASSERT_EQ(condensed.n_elem, 3);
+	EXPECT_NEAR(matrix(0, 1), 0.0, 1e-3);
+	EXPECT_NEAR(matrix(0, 2), pdb->kabsch_rmsd(*perturbed), 1e-4);
+	EXPECT_NEAR(matrix(1, 2), moved->kabsch_rmsd(*perturbed), 1e-4);
+	EXPECT_EQ(condensed(0), matrix(0, 1));
+	EXPECT_EQ(condensed(1), matrix(0, 2));
+	EXPECT_EQ(condensed(2), matrix(1, 2));
+
+	// every structure needs the same number of atoms
+	auto other = std::make_shared<PDB<TypeParam>>("helix.pdb");
+	EXPECT_ANY_THROW(PDB<TypeParam>::kabsch_rmsd_matrix({ pdb, other }));
+}
+
 TYPED_TEST(PDBTest, phi_angles)
 {
 	auto pdb = PDB<TypeParam>("test.pdb");
@@ -126,6 +300,112 @@ TYPED_TEST(PDBTest, psi_angles)
 	EXPECT_NEAR(psi_rad(10), 1.6497685, get_epsilon<TypeParam>());
 }
 
+TYPED_TEST(PDBTest, omega_angles)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+
+	// trans peptide bonds, except at the end of the chains
+	const arma::Col<TypeParam> all_omega = arma::abs(pdb.calculate_omega());
+	const arma::Col<TypeParam> omega = all_omega.elem(arma::find(all_omega));
+	EXPECT_GT(omega.n_elem, pdb.n_residues() - 4);
+	EXPECT_GT(arma::median(omega), 170);
+}
+
+TYPED_TEST(PDBTest, PeptideBonds)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	auto residues = pdb.get_residues();
+
+	// the atoms are created on first use, with the peptide bonds to both neighbours
+	auto first_c = residues[0]->get_atom(2);
+	ASSERT_EQ(first_c->get_name(), "C");
+	EXPECT_EQ(first_c->getNumberOfBonds(), 3); // CA, O and the N of the next residue
+
+	auto second_n = residues[1]->get_atom(0);
+	ASSERT_EQ(second_n->get_name(), "N");
+	EXPECT_EQ(second_n->getNumberOfBonds(), 2); // CA and the C of the previous residue
+	EXPECT_TRUE(second_n->hasBond(first_c));
+
+	EXPECT_EQ(residues[0]->get_atom(0)->getNumberOfBonds(), 1);
+}
+
+TYPED_TEST(PDBTest, torsions)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+
+	// a single pass of kernels with different windows
+	const arma::Mat<TypeParam> torsions = pdb.calculate_torsions();
+	ASSERT_EQ(torsions.n_rows, 8);
+	ASSERT_EQ(torsions.n_cols, pdb.n_residues());
+
+	const std::vector<arma::Col<TypeParam>> expected { pdb.calculate_phi(), pdb.calculate_psi(),
+		pdb.calculate_omega(), pdb.calculate_chi1(), pdb.calculate_chi2(), pdb.calculate_chi3(),
+		pdb.calculate_chi4(), pdb.calculate_chi5() };
+	for (arma::uword i = 0; i < expected.size(); ++i)
+	{
+		EXPECT_TRUE(arma::approx_equal(torsions.row(i).t(), expected[i], "absdiff", 1e-4))
+			<< "torsion " << i;
+	}
+	// the last residue has no backbone torsions, but has side chain torsions
+	EXPECT_EQ(torsions(0, pdb.n_residues() - 1), 0);
+	EXPECT_NEAR(torsions(3, pdb.n_residues() - 1), expected[3](pdb.n_residues() - 1), 1e-4);
+}
+
+TYPED_TEST(PDBTest, backbone_torsions)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> backbone = pdb.get_backbone_atoms();
+	std::vector<bool> chain_start;
+	for (const auto& residue : pdb.get_residues())
+		chain_start.push_back(residue->is_n_terminus());
+
+	arma::Mat<TypeParam> torsions;
+	geometry::backbone_torsions(backbone, chain_start, false, torsions);
+	EXPECT_NEAR(torsions(0, 10), -76.065502471, get_epsilon<TypeParam>());
+	EXPECT_NEAR(torsions(1, 10), 94.52472, get_epsilon<TypeParam>());
+
+	// the same result (e.g. for each frame of a trajectory) is not reallocated
+	const TypeParam* memory = torsions.memptr();
+	geometry::backbone_torsions(backbone, chain_start, true, torsions);
+	EXPECT_EQ(torsions.memptr(), memory);
+	EXPECT_NEAR(torsions(0, 10), -1.3275937, get_epsilon<TypeParam>());
+}
+
+TYPED_TEST(PDBTest, vector_atan2)
+{
+	// every quadrant, the axes and both sides of the reductions (tan(pi / 8) and 0.66)
+	const TypeParam tolerance = std::is_same_v<TypeParam, float> ? 5e-7 : 1e-15;
+	for (TypeParam y : { -3.0, -1.0, -0.5, -0.41, 0.0, 0.41, 0.42, 0.65, 0.67, 1.0, 2.5 })
+	{
+		for (TypeParam x : { -2.0, -1.0, -0.3, 0.0, 0.3, 0.5, 1.0, 4.0 })
+			EXPECT_NEAR(kernels::vector_atan2(y, x), std::atan2(y, x), tolerance) << y << ", " << x;
+	}
+}
+
+TYPED_TEST(PDBTest, backbone_torsions_into)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> expected = pdb.calculate_backbone_torsions();
+
+	// the backbone is read in place, with the same result as from the copy
+	arma::Mat<TypeParam> torsions;
+	pdb.calculate_backbone_torsions(torsions);
+	ASSERT_EQ(torsions.n_cols, expected.n_cols);
+	EXPECT_TRUE(arma::approx_equal(torsions, expected, "absdiff", 1e-4));
+
+	// later frames reuse the memory of the result and follow the coordinates
+	const TypeParam* memory = torsions.memptr();
+	pdb.recentre();
+	pdb.calculate_backbone_torsions(torsions, true);
+	EXPECT_EQ(torsions.memptr(), memory);
+	EXPECT_NEAR(torsions(0, 10), -1.3275937, get_epsilon<TypeParam>());
+
+	// copies share the layout of the backbone
+	auto copy = pdb;
+	arma::Mat<TypeParam> copy_torsions;
+	copy.calculate_backbone_torsions(copy_torsions, true);
+	EXPECT_TRUE(arma::approx_equal(copy_torsions, torsions, "absdiff", 1e-4));
+}
 
 TYPED_TEST(PDBTest, chi1_angles)
 {
@@ -190,4 +470,76 @@ TYPED_TEST(PDBTest, chi5_angles)
 	auto chi5_rad = pdb.calculate_chi5(true);
 
 	EXPECT_NEAR(arma::accu(chi5_rad), -6.1489725, get_epsilon<TypeParam>());
-}
\ No newline at end of file
+}
+
+TYPED_TEST(PDBTest, NeighbourPairs)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const TypeParam threshold = 5.0;
+
+	// the pairs are the upper triangle of the dense contact matrix
+	auto neighbours = pdb.compute_neighbours(threshold);
+	auto pairs = pdb.compute_neighbour_pairs(threshold);
+
+	ASSERT_EQ(pairs.n_rows, 2);
+	ASSERT_EQ(pairs.n_cols, arma::accu(arma::trimatu(neighbours)));
+	for (arma::uword pair = 0; pair < pairs.n_cols; ++pair)
+	{
+		const auto i = static_cast<arma::uword>(pairs(0, pair));
+		const auto j = static_cast<arma::uword>(pairs(1, pair));
+		EXPECT_LT(i, j);
+		EXPECT_EQ(neighbours(i, j), 1);
+	}
+
+	auto distances = pdb.compute_shortest_distance();
+	auto distance_pairs = pdb.compute_shortest_distance_pairs(threshold);
+
+	ASSERT_EQ(distance_pairs.n_rows, 3);
+	ASSERT_EQ(distance_pairs.n_cols, pairs.n_cols);
+	for (arma::uword pair = 0; pair < distance_pairs.n_cols; ++pair)
+	{
+		const auto i = static_cast<arma::uword>(distance_pairs(0, pair));
+		const auto j = static_cast<arma::uword>(distance_pairs(1, pair));
+		EXPECT_NEAR(distance_pairs(2, pair), distances(i, j), get_epsilon<TypeParam>());
+	}
+}
+
+TYPED_TEST(PDBTest, StructureCache)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const std::string filename = "structure_cache_test.bin";
+	pdb.save(filename);
+
+	auto cached = PDB<TypeParam>::load(filename);
+	EXPECT_EQ(cached->get_filename(), "test.pdb");
+	EXPECT_EQ(cached->n_atoms(), pdb.n_atoms());
+	EXPECT_EQ(cached->n_residues(), pdb.n_residues());
+	EXPECT_EQ(cached->get_chain_names(), pdb.get_chain_names());
+	EXPECT_EQ(cached->get_table_positions(), pdb.get_table_positions());
+	EXPECT_TRUE(arma::approx_equal(cached->get_xyz(), pdb.get_xyz(), "absdiff", 0));
+	EXPECT_TRUE(arma::approx_equal(cached->get_radii(), pdb.get_radii(), "absdiff", 0));
+	EXPECT_TRUE(arma::approx_equal(cached->calculate_phi_psi(), pdb.calculate_phi_psi(),
+		"absdiff", get_epsilon<TypeParam>()));
+
+	auto residues = pdb.get_residues();
+	auto cached_residues = cached->get_residues();
+	for (size_t i = 0; i < residues.size(); ++i)
+	{
+		EXPECT_EQ(cached_residues[i]->get_name(), residues[i]->get_name());
+		EXPECT_EQ(cached_residues[i]->get_amino_acid_type(), residues[i]->get_amino_acid_type());
+	}
+
+	// the cache can be loaded with either precision
+	auto converted = PDB<double>::load(filename);
+	EXPECT_EQ(converted->n_atoms(), pdb.n_atoms());
+
+	// a corrupted file fails the checksum
+	{
+		std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(-1, std::ios::end);
+		file.put('\x7f');
+	}
+	EXPECT_THROW(PDB<TypeParam>::load(filename), std::string);
+	std::remove(filename.c_str());
+	EXPECT_THROW(PDB<TypeParam>::load(filename), const char*);
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/pdb/cell_list.h"
+#include "prostruct/prostruct.h"
+
+using namespace prostruct;
+
+TEST(CellListTest, MatchesBruteForce)
+{
+	auto pdb = PDB<double>("test.pdb");
+	const arma::Mat<double> xyz = pdb.get_xyz();
+	const arma::Col<double> radii = pdb.get_radii();
+
+	const auto neighbours = geometry::neighbour_list(xyz, radii, 1.4);
+	ASSERT_EQ(neighbours.n_points(), xyz.n_cols);
+
+	for (arma::uword i = 0; i < xyz.n_cols; ++i)
+	{
+		std::vector<arma::uword> expected;
+		for (arma::uword j = 0; j < xyz.n_cols; ++j)
+		{
+			const double cutoff = radii(i) + radii(j) + 1.4;
+			if (i != j && arma::accu(arma::square(xyz.col(i) - xyz.col(j))) < cutoff * cutoff)
+				expected.push_back(j);
+		}
+		ASSERT_EQ(std::vector<arma::uword>(neighbours.begin(i), neighbours.end(i)), expected);
+	}
+}
+
+TEST(CellListTest, Cutoff)
+{
+	// three points on a line and one far away
+	const arma::Mat<float> xyz = { { 0, 1, 2.5, 100 }, { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+
+	const auto neighbours = geometry::neighbour_list(xyz, 1.6f);
+
+	ASSERT_EQ(neighbours.n_neighbours(0), 1);
+	ASSERT_EQ(neighbours.n_neighbours(1), 2);
+	ASSERT_EQ(neighbours.n_neighbours(2), 1);
+	ASSERT_EQ(neighbours.n_neighbours(3), 0);
+	ASSERT_EQ(*neighbours.begin(0), 1);
+	ASSERT_EQ(*neighbours.begin(2), 1);
+}
@@ -0,0 +1,118 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/prostruct.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace prostruct;
+
+namespace
+{
+	/**
+	 * Writes the atoms of test.pdb as n_models models, where model i is
+	 * translated by i along x.
+	 */
+	std::string write_ensemble(int n_models)
+	{
+		std::vector<std::string> atoms;
+		std::ifstream input("test.pdb");
+		for (std::string line; std::getline(input, line);)
+		{
+			if (line.compare(0, 4, "ATOM") == 0)
+				atoms.push_back(line);
+		}
+
+		const std::string filename = "ensemble.pdb";
+		std::ofstream output(filename);
+		for (int model = 0; model < n_models; ++model)
+		{
+			output << "MODEL     " << model + 1 << "\n";
+			for (auto line : atoms)
+			{
+				char x[9];
+				std::snprintf(x, sizeof(x), "%8.3f", std::stod(line.substr(30, 8)) + model);
+				line.replace(30, 8, x);
+				output << line << "\n";
+			}
+			output << "ENDMDL\n";
+		}
+		output << "END\n";
+		return filename;
+	}
+}
+
+template <typename T>
+class EnsembleTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(EnsembleTest, floatTypes);
+
+TYPED_TEST(EnsembleTest, Models)
+{
+	const auto filename = write_ensemble(3);
+	auto single = PDB<TypeParam>("test.pdb");
+
+	// a PDB of a multi-model file is its first model
+	auto first_model = PDB<TypeParam>(filename);
+	ASSERT_EQ(first_model.n_atoms(), single.n_atoms());
+
+	auto ensemble = Ensemble<TypeParam>(filename);
+	ASSERT_EQ(ensemble.n_models(), 3);
+	ASSERT_EQ(ensemble.n_atoms(), single.n_atoms());
+	ASSERT_EQ(ensemble.n_residues(), single.n_residues());
+
+	const arma::Col<TypeParam> centroid = ensemble.calculate_centroid();
+	const arma::Mat<TypeParam> residue_xyz = ensemble.get_residues()[10]->get_xyz();
+
+	ensemble.set_model(2);
+	EXPECT_EQ(ensemble.current_model(), 2);
+	EXPECT_NEAR(ensemble.calculate_centroid()(0), centroid(0) + 2, 1e-3);
+	// the residues see the coordinates of the current model
+	EXPECT_NEAR(ensemble.get_residues()[10]->get_xyz()(0, 0), residue_xyz(0, 0) + 2, 1e-3);
+	EXPECT_NEAR(ensemble.get_residues()[10]->get_xyz()(1, 0), residue_xyz(1, 0), 1e-3);
+
+	const auto model = ensemble.get_model(1);
+	EXPECT_EQ(model.index(), 1);
+	EXPECT_NEAR(model.xyz(0, 0), ensemble.get_model_xyz(0)(0, 0) + 1, 1e-3);
+
+	// the models only differ by a translation
+	const arma::Mat<TypeParam> rmsd = ensemble.compute_rmsd_matrix();
+	EXPECT_LT(rmsd.max(), 1e-3);
+
+	std::vector<TypeParam> x;
+	ensemble.for_each_model([&](arma::uword) { x.push_back(ensemble.calculate_centroid()(0)); });
+	ASSERT_EQ(x.size(), 3);
+	EXPECT_NEAR(x[1] - x[0], 1, 1e-3);
+
+	EXPECT_THROW(ensemble.set_model(3), std::string);
+
+	std::remove(filename.c_str());
+}
+
+TYPED_TEST(EnsembleTest, ParseModels)
+{
+	const auto filename = write_ensemble(3);
+
+	// a PDB only keeps the first model, so the others are not read
+	const auto first_model = parsers::parse_pdb<TypeParam>(filename);
+	EXPECT_EQ(first_model.n_models, 1);
+	EXPECT_TRUE(first_model.model_xyz.empty());
+	EXPECT_EQ(first_model.model_xyz.capacity(), 0);
+
+	const auto all_models = parsers::parse_pdb<TypeParam>(filename, true);
+	EXPECT_EQ(all_models.n_models, 3);
+	EXPECT_EQ(all_models.atoms.size(), first_model.atoms.size());
+	EXPECT_EQ(all_models.model_xyz.size(), 3 * 2 * first_model.atoms.size());
+
+	std::remove(filename.c_str());
+}
@@ -0,0 +1,70 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/prostruct.h"
+
+#include <algorithm>
+
+using namespace prostruct;
+
+template <typename T>
+class LoaderTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(LoaderTest, floatTypes);
+
+TYPED_TEST(LoaderTest, InputOrder)
+{
+	const std::vector<std::string> filenames
+		= { "test.pdb", "missing.pdb", "test.pdb", "test.pdb", "missing.pdb", "test.pdb" };
+	LoadTimings timings;
+	auto results = load_many<TypeParam>(filenames, 2, true, &timings);
+
+	const auto reference = PDB<TypeParam>("test.pdb");
+	ASSERT_EQ(results.size(), filenames.size());
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		EXPECT_EQ(results[i].index, i);
+		EXPECT_EQ(results[i].filename, filenames[i]);
+		if (filenames[i] == "missing.pdb")
+		{
+			// the error of a file does not stop the others
+			EXPECT_FALSE(results[i].ok());
+			EXPECT_EQ(results[i].error, "File does not exist!");
+			continue;
+		}
+		ASSERT_TRUE(results[i].ok());
+		EXPECT_EQ(results[i].structure->n_atoms(), reference.n_atoms());
+		EXPECT_EQ(results[i].structure->n_residues(), reference.n_residues());
+		EXPECT_TRUE(arma::approx_equal(
+			results[i].structure->get_xyz(), reference.get_xyz(), "absdiff", 1e-6));
+	}
+	EXPECT_GT(timings.decode_ms, 0);
+	EXPECT_GT(timings.assemble_ms, 0);
+}
+
+TYPED_TEST(LoaderTest, CompletionOrder)
+{
+	const std::vector<std::string> filenames(20, "test.pdb");
+	PDBLoader<TypeParam> loader(filenames, 4, false);
+
+	std::vector<size_t> indices;
+	while (auto result = loader.next())
+	{
+		EXPECT_TRUE(result->ok());
+		indices.push_back(result->index);
+	}
+
+	std::sort(indices.begin(), indices.end());
+	ASSERT_EQ(indices.size(), filenames.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+		EXPECT_EQ(indices[i], i);
+}
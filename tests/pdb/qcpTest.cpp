@@ -0,0 +1,118 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/pdb/qcp.h"
+#include "prostruct/prostruct.h"
+
+using namespace prostruct;
+
+template <typename T>
+class QCPTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(QCPTest, floatTypes);
+
+template <typename T>
+arma::Col<T> centroid_of(const arma::Mat<T>& xyz)
+{
+	arma::Col<T> centroid(3);
+	geometry::get_centroid(xyz, centroid);
+	return centroid;
+}
+
+template <typename T>
+arma::Mat<T> rotation_about_z(T angle)
+{
+	return { { std::cos(angle), -std::sin(angle), 0 }, { std::sin(angle), std::cos(angle), 0 },
+		{ 0, 0, 1 } };
+}
+
+TYPED_TEST(QCPTest, RecoversRotation)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+
+	const arma::Mat<TypeParam> R = rotation_about_z<TypeParam>(0.9);
+	arma::Mat<TypeParam> target = R * xyz;
+	target.each_col() += arma::Col<TypeParam> { 10, -5, 3 };
+
+	const auto inner_product
+		= geometry::qcp_inner_product(xyz, centroid_of(xyz), target, centroid_of(target));
+
+	EXPECT_NEAR(geometry::qcp_rmsd(inner_product), 0.0, 1e-3);
+	EXPECT_LT(arma::abs(geometry::qcp_rotation<TypeParam>(inner_product) - R).max(), 1e-4);
+}
+
+TYPED_TEST(QCPTest, MatchesSVD)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+
+	arma::arma_rng::set_seed(42);
+	arma::Mat<TypeParam> target = rotation_about_z<TypeParam>(-2.0) * xyz;
+	target += arma::randn<arma::Mat<TypeParam>>(3, xyz.n_cols);
+
+	// reference: Kabsch with an SVD of the inner product matrix, in double
+	arma::Mat<double> P = arma::conv_to<arma::Mat<double>>::from(xyz);
+	arma::Mat<double> Q = arma::conv_to<arma::Mat<double>>::from(target);
+	P.each_col() -= arma::mean(P, 1);
+	Q.each_col() -= arma::mean(Q, 1);
+	arma::Mat<double> U, V;
+	arma::Col<double> s;
+	arma::svd(U, s, V, P * Q.t());
+	arma::Mat<double> I = arma::eye<arma::Mat<double>>(3, 3);
+	I.at(2, 2) = arma::det(V * U.t()) > 0 ? 1 : -1;
+	const arma::Mat<double> R = V * I * U.t();
+	const double expected = std::sqrt(arma::accu(arma::square(R * P - Q)) / xyz.n_cols);
+
+	const auto inner_product
+		= geometry::qcp_inner_product(xyz, centroid_of(xyz), target, centroid_of(target));
+
+	EXPECT_NEAR(geometry::qcp_rmsd(inner_product), expected, 1e-3);
+
+	const arma::Mat<TypeParam> rotation = geometry::qcp_rotation<TypeParam>(inner_product);
+	EXPECT_LT(arma::abs(arma::conv_to<arma::Mat<double>>::from(rotation) - R).max(), 1e-4);
+}
+
+TYPED_TEST(QCPTest, RMSDMatrix)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+
+	// rotated and perturbed copies of the structure
+	arma::arma_rng::set_seed(1);
+	const arma::uword n_frames = 7;
+	arma::Cube<TypeParam> frames(3, xyz.n_cols, n_frames);
+	for (arma::uword i = 0; i < n_frames; ++i)
+	{
+		frames.slice(i) = rotation_about_z<TypeParam>(0.5 * i) * xyz
+			+ TypeParam(0.2 * i) * arma::randn<arma::Mat<TypeParam>>(3, xyz.n_cols);
+	}
+
+	const arma::Mat<TypeParam> matrix = geometry::rmsd_matrix(frames);
+	const arma::Col<TypeParam> condensed = geometry::condensed_rmsd_matrix(frames);
+
+	ASSERT_EQ(matrix.n_rows, n_frames);
+	ASSERT_EQ(condensed.n_elem, n_frames * (n_frames - 1) / 2);
+
+	arma::uword k = 0;
+	for (arma::uword i = 0; i < n_frames; ++i)
+	{
+		EXPECT_EQ(matrix(i, i), 0);
+		for (arma::uword j = i + 1; j < n_frames; ++j, ++k)
+		{
+			const TypeParam expected = geometry::kabsch_rmsd_(frames.slice(i), frames.slice(j));
+			EXPECT_NEAR(matrix(i, j), expected, 1e-4);
+			EXPECT_EQ(matrix(j, i), matrix(i, j));
+			EXPECT_EQ(condensed(k), matrix(i, j));
+		}
+	}
+}
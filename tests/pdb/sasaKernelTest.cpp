@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/pdb/sasa_kernel.h"
+
+using namespace prostruct::geometry;
+
+template <typename T>
+class SasaKernelTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(SasaKernelTest, floatTypes);
+
+TYPED_TEST(SasaKernelTest, NoNeighbours)
+{
+	const SpherePoints<TypeParam> sphere(100);
+	const NeighbourSpheres<TypeParam> neighbours;
+
+	ASSERT_EQ(count_accessible_points(sphere, TypeParam(3), neighbours), 100);
+}
+
+TYPED_TEST(SasaKernelTest, HalfBuried)
+{
+	// a large sphere centred far along x buries (almost) the x > 0 half
+	const SpherePoints<TypeParam> sphere(960);
+	NeighbourSpheres<TypeParam> neighbours;
+	neighbours.push_back(1000, 0, 0, 1000);
+
+	auto accessible = count_accessible_points(sphere, TypeParam(1), neighbours);
+	EXPECT_NEAR(accessible, 480, 10);
+}
+
+TYPED_TEST(SasaKernelTest, SimdLevelsAgree)
+{
+	const SpherePoints<TypeParam> sphere(961);
+	NeighbourSpheres<TypeParam> neighbours;
+	for (int i = 0; i < 12; ++i)
+		neighbours.push_back(3 * std::cos(i), 3 * std::sin(i), 0.5 * (i - 6), 1.8 + 0.05 * i);
+
+	const auto scalar
+		= count_accessible_points(sphere, TypeParam(3.2), neighbours, SimdLevel::Scalar);
+
+	ASSERT_EQ(count_accessible_points(sphere, TypeParam(3.2), neighbours, SimdLevel::AVX2), scalar);
+	ASSERT_EQ(
+		count_accessible_points(sphere, TypeParam(3.2), neighbours, SimdLevel::AVX512), scalar);
+}
@@ -0,0 +1,89 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/prostruct.h"
+
+using namespace prostruct;
+
+template <typename T>
+class SuperposerTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(SuperposerTest, floatTypes);
+
+template <typename T>
+arma::Mat<T> moved_copy(const arma::Mat<T>& xyz, T angle)
+{
+	const arma::Mat<T> R = { { std::cos(angle), 0, std::sin(angle) }, { 0, 1, 0 },
+		{ -std::sin(angle), 0, std::cos(angle) } };
+	arma::Mat<T> result = R * xyz;
+	result.each_col() += arma::Col<T> { -4, 7, 1 };
+	return result;
+}
+
+TYPED_TEST(SuperposerTest, SameSelection)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+
+	arma::arma_rng::set_seed(7);
+	const arma::Mat<TypeParam> other
+		= moved_copy<TypeParam>(xyz, 1.2) + arma::randn<arma::Mat<TypeParam>>(3, xyz.n_cols);
+
+	const arma::Col<arma::uword> all = arma::regspace<arma::Col<arma::uword>>(0, xyz.n_cols - 1);
+	geometry::Superposer<TypeParam> superposer(xyz, all);
+
+	EXPECT_NEAR(superposer.rmsd(other), geometry::kabsch_rmsd_(other, xyz), 1e-4);
+}
+
+TYPED_TEST(SuperposerTest, FitOnCAScoreOnHeavyAtoms)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+	const arma::Col<arma::uword> ca = pdb.get_atom_indices("CA");
+	const arma::Col<arma::uword> heavy = pdb.get_heavy_atom_indices();
+
+	geometry::Superposer<TypeParam> superposer(xyz, ca, heavy);
+	ASSERT_EQ(superposer.n_fit_atoms(), pdb.n_residues());
+
+	// a rigid motion is undone by fitting on any selection
+	arma::Mat<TypeParam> other = moved_copy<TypeParam>(xyz, -0.4);
+	EXPECT_NEAR(superposer.rmsd(other), 0.0, 1e-3);
+
+	// moving only the sidechains changes the score but not the fit
+	arma::Mat<TypeParam> perturbed = xyz;
+	arma::uword n_moved = 0;
+	for (const auto atom : heavy)
+	{
+		if (arma::any(ca == atom))
+			continue;
+		perturbed(0, atom) += 1;
+		++n_moved;
+	}
+	other = moved_copy<TypeParam>(perturbed, 2.0);
+
+	const TypeParam expected = std::sqrt(TypeParam(n_moved) / heavy.n_elem);
+	EXPECT_NEAR(superposer.rmsd(other), expected, 1e-3);
+
+	EXPECT_NEAR(superposer.superpose(other), expected, 1e-3);
+	EXPECT_NEAR(geometry::rmsd<TypeParam>(other.cols(ca), xyz.cols(ca)), 0.0, 1e-3);
+}
+
+TYPED_TEST(SuperposerTest, AtomNumberMismatch)
+{
+	auto pdb = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> xyz = pdb.get_xyz();
+
+	geometry::Superposer<TypeParam> superposer(xyz, pdb.get_atom_indices("CA"));
+	const arma::Mat<TypeParam> smaller = xyz.head_cols(10);
+
+	EXPECT_THROW(superposer.rmsd(smaller), const char*);
+}
@@ -0,0 +1,179 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "prostruct/prostruct.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace prostruct;
+
+namespace
+{
+	void write_record(std::ofstream& output, const void* data, std::int32_t size)
+	{
+		output.write(reinterpret_cast<const char*>(&size), 4);
+		output.write(static_cast<const char*>(data), size);
+		output.write(reinterpret_cast<const char*>(&size), 4);
+	}
+
+	/**
+	 * Writes the first n_atoms atoms of test.pdb as a CHARMM DCD file with a unit
+	 * cell and n_frames frames, where frame i is translated by (i, -2i, 0).
+	 */
+	std::string write_dcd(int n_frames, size_t n_atoms = 0)
+	{
+		std::vector<float> x, y, z;
+		std::ifstream input("test.pdb");
+		for (std::string line; std::getline(input, line);)
+		{
+			if (line.compare(0, 4, "ATOM") == 0)
+			{
+				x.push_back(std::stof(line.substr(30, 8)));
+				y.push_back(std::stof(line.substr(38, 8)));
+				z.push_back(std::stof(line.substr(46, 8)));
+			}
+		}
+		if (n_atoms > 0)
+		{
+			x.resize(n_atoms);
+			y.resize(n_atoms);
+			z.resize(n_atoms);
+		}
+
+		const std::string filename = "test.dcd";
+		std::ofstream output(filename, std::ios::binary);
+
+		char header[84] = { 'C', 'O', 'R', 'D' };
+		std::int32_t icntrl[20] = { n_frames };
+		icntrl[10] = 1; // unit cell
+		icntrl[19] = 24; // CHARMM version
+		std::memcpy(header + 4, icntrl, sizeof(icntrl));
+		write_record(output, header, sizeof(header));
+
+		char title[4 + 80] = {};
+		std::int32_t n_titles = 1;
+		std::memcpy(title, &n_titles, 4);
+		write_record(output, title, sizeof(title));
+
+		const auto natoms = static_cast<std::int32_t>(x.size());
+		write_record(output, &natoms, 4);
+
+		for (int frame = 0; frame < n_frames; ++frame)
+		{
+			const double cell[6] = { 50, 90, 50, 90, 90, 50 };
+			write_record(output, cell, sizeof(cell));
+
+			std::vector<float> frame_x(x), frame_y(y);
+			for (auto& value : frame_x)
+				value += frame;
+			for (auto& value : frame_y)
+				value -= 2 * frame;
+			write_record(output, frame_x.data(), 4 * natoms);
+			write_record(output, frame_y.data(), 4 * natoms);
+			write_record(output, z.data(), 4 * natoms);
+		}
+		return filename;
+	}
+}
+
+template <typename T>
+class TrajectoryTest : public ::testing::Test {
+};
+using floatTypes = ::testing::Types<float, double>;
+
+TYPED_TEST_CASE(TrajectoryTest, floatTypes);
+
+TYPED_TEST(TrajectoryTest, DCD)
+{
+	const auto filename = write_dcd(3);
+	auto reference = PDB<TypeParam>("test.pdb");
+	auto pdb = std::make_shared<PDB<TypeParam>>("test.pdb");
+	const arma::Mat<TypeParam> residue_xyz = pdb->get_residues()[10]->get_xyz();
+
+	Trajectory<TypeParam> trajectory(pdb, filename);
+	ASSERT_EQ(trajectory.n_atoms(), 1867);
+	EXPECT_THROW(trajectory.frame(), const char*);
+
+	arma::uword n_frames = 0;
+	trajectory.for_each_frame([&](arma::uword frame) {
+		EXPECT_EQ(frame, n_frames++);
+		// the residues see the coordinates of the frame
+		const arma::Mat<TypeParam> xyz = pdb->get_residues()[10]->get_xyz();
+		EXPECT_NEAR(xyz(0, 0), residue_xyz(0, 0) + frame, 1e-3);
+		EXPECT_NEAR(xyz(1, 0), residue_xyz(1, 0) - 2.0 * frame, 1e-3);
+		EXPECT_NEAR(xyz(2, 0), residue_xyz(2, 0), 1e-3);
+		EXPECT_LT(pdb->kabsch_rmsd(reference), 1e-2);
+	});
+	EXPECT_EQ(n_frames, 3);
+	EXPECT_FALSE(trajectory.next());
+
+	std::remove(filename.c_str());
+}
+
+TYPED_TEST(TrajectoryTest, XTC)
+{
+	// test.xtc has the atoms of test.pdb translated by (0, 0, 0), (10, -5, 2)
+	// and (-3.5, 1.25, 7), compressed with a precision of 0.01 Angstrom. It is
+	// written by tests/make_test_xtc.py (a port of the compression of GROMACS'
+	// xdrfile), with python3 tests/make_test_xtc.py tests/test.pdb tests/test.xtc
+	const TypeParam shifts[3][3] = { { 0, 0, 0 }, { 10, -5, 2 }, { -3.5, 1.25, 7 } };
+	auto reference = PDB<TypeParam>("test.pdb");
+	const arma::Mat<TypeParam> reference_xyz = reference.get_xyz();
+
+	for (size_t n_buffers : { 0, 2 })
+	{
+		auto pdb = std::make_shared<PDB<TypeParam>>("test.pdb");
+		Trajectory<TypeParam> trajectory(pdb, "test.xtc", n_buffers);
+
+		arma::uword n_frames = 0;
+		while (trajectory.next())
+		{
+			ASSERT_LT(n_frames, 3);
+			const arma::Mat<TypeParam> xyz = pdb->get_xyz();
+			TypeParam max_error = 0;
+			for (arma::uword atom = 0; atom < xyz.n_cols; ++atom)
+			{
+				for (arma::uword i = 0; i < 3; ++i)
+					max_error = std::max(max_error,
+						std::abs(xyz(i, atom) - reference_xyz(i, atom) - shifts[n_frames][i]));
+			}
+			EXPECT_LT(max_error, 1e-2);
+			++n_frames;
+		}
+		EXPECT_EQ(n_frames, 3);
+	}
+}
+
+TYPED_TEST(TrajectoryTest, AtomNumberMismatch)
+{
+	const auto filename = write_dcd(1, 100);
+	auto pdb = std::make_shared<PDB<TypeParam>>("test.pdb");
+	EXPECT_THROW({ Trajectory<TypeParam> trajectory(pdb, filename); }, const char*);
+	std::remove(filename.c_str());
+}
+
+TYPED_TEST(TrajectoryTest, SharesTopology)
+{
+	const auto filename = write_dcd(2);
+	auto pdb = std::make_shared<PDB<TypeParam>>("test.pdb");
+	Trajectory<TypeParam> trajectory(pdb, filename);
+
+	// the trajectory keeps the topology alive, e.g. when Python releases it
+	std::weak_ptr<PDB<TypeParam>> topology = pdb;
+	pdb.reset();
+	EXPECT_FALSE(topology.expired());
+	EXPECT_TRUE(trajectory.next());
+	EXPECT_EQ(trajectory.frame(), 0);
+
+	std::remove(filename.c_str());
+}
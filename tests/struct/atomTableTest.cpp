@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE', which is part of this source code package.
+ *
+ * Authors: Gil Hoben
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include <prostruct/struct/residue.h>
+
+using namespace prostruct;
+
+TEST(AtomTableTest, PackAtomName)
+{
+	ASSERT_EQ(pack_atom_name("CA"), pack_atom_name("CA"));
+	ASSERT_NE(pack_atom_name("CA"), pack_atom_name("C"));
+	ASSERT_EQ(unpack_atom_name(pack_atom_name("HH11")), "HH11");
+	ASSERT_EQ(unpack_atom_name(pack_atom_name("N")), "N");
+}
+
+TEST(AtomTableTest, ElementCode)
+{
+	ASSERT_EQ(element_code("C"), 6);
+	ASSERT_EQ(element_code("FE"), 26);
+	ASSERT_EQ(element_code("Fe"), 26);
+	ASSERT_EQ(element_symbol(26), "Fe");
+}
+
+TEST(AtomTableTest, ResidueView)
+{
+	auto table = std::make_shared<AtomTable<double>>(5);
+	table->set_atom(0, 7, pack_atom_name("N"), 24.005, 32.219, -1.031, 0);
+	table->set_atom(1, 6, pack_atom_name("CA"), 24.663, 31.095, -0.361, 0);
+	table->set_atom(2, 6, pack_atom_name("C"), 26.135, 31.308, -0.066, 0);
+	table->set_atom(3, 8, pack_atom_name("O"), 26.715, 32.344, -0.405, 0);
+	table->set_atom(4, 8, pack_atom_name("OXT"), 26.720, 30.385, 0.515, 0);
+
+	auto gly = Residue<double>(table, 0, 5, "GLY", "GLY-1-");
+
+	ASSERT_TRUE(gly.is_table_view());
+	ASSERT_EQ(gly.n_atoms(), 5);
+	ASSERT_EQ(table->radii().at(1), 1.87);
+	ASSERT_EQ(gly.get_atom_indices("CA")(0), 1);
+
+	// the Atom objects are views into the table
+	auto atoms = gly.getAtoms();
+	ASSERT_EQ(atoms[0]->get_name(), "N");
+	ASSERT_EQ(atoms[0]->getX(), 24.005);
+	table->xyz().at(0, 0) = 1.0;
+	ASSERT_EQ(atoms[0]->getX(), 1.0);
+	ASSERT_TRUE(atoms[1]->hasBond(atoms[0]));
+}
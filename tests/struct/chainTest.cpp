@@ -47,4 +47,33 @@ TEST(ResidueTest, SimpleTwoAASequence)
 	ASSERT_EQ(arg->getBackbone()[0]->get_name(), "N");
 
 	ASSERT_TRUE(asp->getBackbone()[2]->hasBond(arg->getBackbone()[0]));
-}
\ No newline at end of file
+}
+
+TEST(ChainTest, HeavyAtomsOfResidues)
+{
+	// ALA and GLY with the hydrogen of their amide group
+	auto table = std::make_shared<AtomTable<double>>(11);
+	table->set_atom(0, element_code("N"), pack_atom_name("N"), 35.446, 51.519, 6.329, 0);
+	table->set_atom(1, element_code("C"), pack_atom_name("CA"), 35.098, 51.281, 4.896, 0);
+	table->set_atom(2, element_code("C"), pack_atom_name("C"), 33.588, 51.392, 4.684, 0);
+	table->set_atom(3, element_code("O"), pack_atom_name("O"), 33.012, 50.680, 3.858, 0);
+	table->set_atom(4, element_code("C"), pack_atom_name("CB"), 35.595, 49.896, 4.462, 0);
+	table->set_atom(5, element_code("H"), pack_atom_name("H"), 35.957, 52.360, 6.520, 0);
+	table->set_atom(6, element_code("N"), pack_atom_name("N"), 32.964, 52.298, 5.433, 1);
+	table->set_atom(7, element_code("C"), pack_atom_name("CA"), 31.521, 52.533, 5.366, 1);
+	table->set_atom(8, element_code("C"), pack_atom_name("C"), 31.011, 52.774, 3.947, 1);
+	table->set_atom(9, element_code("O"), pack_atom_name("O"), 30.021, 52.173, 3.525, 1);
+	table->set_atom(10, element_code("H"), pack_atom_name("H"), 33.455, 52.876, 6.097, 1);
+
+	auto ala = std::make_shared<Residue<double>>(table, 0, 6, "ALA", "ALA1");
+	auto gly = std::make_shared<Residue<double>>(table, 6, 5, "GLY", "GLY2");
+
+	// a chain without a table of its own reads the elements of its residues
+	auto chain = Chain<double>(residueVector<double>({ ala, gly }), "Chain1");
+	ASSERT_EQ(chain.n_atoms(), 11);
+	const arma::Col<arma::uword> heavy = chain.get_heavy_atom_indices();
+
+	const arma::Col<arma::uword> expected = { 0, 1, 2, 3, 4, 6, 7, 8, 9 };
+	ASSERT_EQ(heavy.n_elem, expected.n_elem);
+	EXPECT_TRUE(arma::all(heavy == expected));
+}
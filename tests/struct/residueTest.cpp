@@ -8,8 +8,13 @@
 
 #include "gtest/gtest.h"
 
+#include "prostruct/core/kernels.h"
 #include "prostruct/struct/residue.h"
 
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
 using namespace prostruct;
 
 template <typename T>
@@ -77,6 +82,49 @@ TEST(ResidueTest, Argenine)
 	ASSERT_EQ(NH2->getNumberOfBonds(), 1);
 }
 
+TEST(ResidueTest, ChiAtoms)
+{
+	// the atoms of an arginine, except the ones named in skip
+	auto arginine_atoms = [](const std::vector<std::string>& skip) {
+		const std::vector<std::tuple<std::string, std::string, double, double, double>> atoms {
+			{ "N", "N", 32.964, 52.298, 5.433 }, { "C", "CA", 31.521, 52.533, 5.366 },
+			{ "C", "C", 31.011, 52.774, 3.947 }, { "O", "O", 30.021, 52.173, 3.525 },
+			{ "C", "CB", 31.143, 53.743, 6.231 }, { "C", "CG", 31.514, 53.618, 7.696 },
+			{ "C", "CD", 31.171, 54.883, 8.482 }, { "N", "NE", 29.739, 55.187, 8.480 },
+			{ "C", "CZ", 29.141, 56.009, 7.622 }, { "N", "NH1", 29.847, 56.622, 6.682 },
+			{ "N", "NH2", 27.832, 56.219, 7.704 }
+		};
+		atomVector<double> result;
+		for (const auto& [element, name, x, y, z] : atoms)
+		{
+			if (std::find(skip.cbegin(), skip.cend(), name) == skip.cend())
+				result.push_back(std::make_shared<Atom<double>>(element, name, x, y, z));
+		}
+		return result;
+	};
+
+	auto arg = std::make_shared<Residue<double>>(arginine_atoms({}), "ARG", "ARG1");
+
+	EXPECT_EQ(arg->get_chi_atom_indices(0), (std::array<int, 4> { 0, 1, 4, 5 }));
+	EXPECT_EQ(arg->get_chi_atom_indices(4), (std::array<int, 4> { 6, 7, 8, 9 }));
+	const arma::Mat<double> xyz = arg->get_xyz();
+	EXPECT_NEAR(kernels::chi1_kernel<double>(false)(arg),
+		kernels::dihedrals_lazy(xyz.col(0), xyz.col(1), xyz.col(4), xyz.col(5), 180.0 / M_PI),
+		1e-10);
+
+	// a missing atom gives NaN rather than the angle of other atoms
+	auto truncated = std::make_shared<Residue<double>>(arginine_atoms({ "NH1" }), "ARG", "ARG1");
+	EXPECT_EQ(truncated->get_chi_atom_indices(4)[3], Residue<double>::missing_chi_atom);
+	EXPECT_TRUE(std::isnan(kernels::chi5_kernel<double>(false)(truncated)));
+	EXPECT_FALSE(std::isnan(kernels::chi4_kernel<double>(false)(truncated)));
+
+	// alanine has no chi angles
+	auto ala = std::make_shared<Residue<double>>(
+		arginine_atoms({ "CG", "CD", "NE", "CZ", "NH1", "NH2" }), "ALA", "ALA1");
+	EXPECT_EQ(ala->get_chi_atom_indices(0)[0], Residue<double>::no_chi_atom);
+	EXPECT_EQ(kernels::chi1_kernel<double>(false)(ala), 0);
+}
+
 TEST(ResidueTest, Asparagine)
 {
 